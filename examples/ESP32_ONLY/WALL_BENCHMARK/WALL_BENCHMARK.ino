@@ -0,0 +1,71 @@
+#include <Lixie_II.h>            // https://github.com/connornishijima/Lixie_II
+
+/*
+   Lixie II Wall Benchmark for ESP32
+   
+   Times compositing on one core and then on both, for a wall far bigger than
+   any single display. Results are printed to the Serial Monitor at 115200 baud:
+
+   lix.composite_cores(2); // Returns how many cores will actually be used
+
+   The wall is split into tiles of a few displays each, and both cores claim tiles
+   until there are none left. Waking the second core costs a little every frame,
+   so it only pays off once there are a few dozen displays or more.
+
+   Each display takes about 270 bytes of RAM, so 400 displays fit comfortably on
+   a plain ESP32. Boards with PSRAM can go to 1,000 and beyond (up to 2,978 Lixie
+   IIs), with a 50 FPS frame needing to be composited in well under 20ms.
+   
+   Frames go to a null output here, so only compositing is timed. Sending
+   8,800 LEDs down a single pin would take far longer than a frame anyway -
+   real walls of this size are driven over the network, see UDP_OUTPUT.
+
+   The same kernels and tile scheduler also build on a PC, where extras/host
+   ("make bench") composites walls of 1,000 to 2,978 displays on a pool of
+   threads and checks every thread count draws the same LEDs.
+*/
+
+#define NUM_DIGITS      400
+#define FRAMES          100
+
+Lixie_II lix(13, NUM_DIGITS);
+
+class Null_Output : public Lixie_Output {
+  public:
+    void show(CRGB *leds, uint16_t n_leds) {}
+};
+Null_Output null_output;
+
+float time_frames() {
+  uint32_t t_start = micros();
+  for (uint16_t i = 0; i < FRAMES; i++) {
+    lix.run();
+  }
+  return (micros() - t_start) / float(FRAMES) / 1000.0;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  lix.begin();
+  lix.stop_animation(); // We'll call run() ourselves
+  lix.output(&null_output);
+
+  lix.color_generator(ON, GENERATOR_RAINBOW, 0, 3);
+  lix.color_all(OFF, CRGB(0, 3, 8));
+  lix.dithering(true); // Different every frame, so every display is redrawn
+  lix.transition_time(60000);
+  lix.write(1234567890);
+
+  for (uint8_t cores = 1; cores <= 2; cores++) {
+    Serial.print(lix.composite_cores(cores));
+    Serial.print(" core(s), ");
+    Serial.print(NUM_DIGITS);
+    Serial.print(" displays: ");
+    Serial.print(time_frames());
+    Serial.println(" ms per frame");
+  }
+}
+
+void loop() {
+}
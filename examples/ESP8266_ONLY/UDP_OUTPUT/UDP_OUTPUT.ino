@@ -0,0 +1,64 @@
+#include <Lixie_II.h>            // https://github.com/connornishijima/Lixie_II
+#include <Lixie_UDP_Output.h>
+
+#include <ESP8266WiFi.h>         // https://github.com/esp8266/Arduino
+#include <WiFiUdp.h>
+
+/*
+   Lixie II UDP Output for ESP8266
+   
+   Renders the display exactly as usual, but instead of driving the LEDs on a local
+   pin the finished frames are sent over WiFi to a remote pixel controller (WLED,
+   FPP, xLights, Falcon, etc.) using either DDP or E1.31 (sACN):
+
+   Lixie_UDP_Output ddp(udp, controller_ip, LIXIE_DDP);
+   Lixie_UDP_Output sacn(udp, controller_ip, LIXIE_E131, universe);
+
+   Frames are sent when they change, and a static display is only resent once a
+   second so the controller knows the source is still there.
+   
+   The ESP8266 can't send packets from inside the Ticker interrupt, so this sketch
+   stops the background animation and calls lix.run() from loop() at 50 FPS instead.
+*/
+
+#define NUM_DIGITS      6
+
+const char* ssid     = "YOUR_SSID";
+const char* password = "YOUR_PASSWORD";
+IPAddress controller_ip(192, 168, 1, 50);
+
+Lixie_II lix(13, NUM_DIGITS); // The pin is unused once the output is replaced
+WiFiUDP udp;
+Lixie_UDP_Output ddp(udp, controller_ip, LIXIE_DDP);
+
+uint32_t last_frame = 0;
+uint32_t last_count = 0;
+uint32_t counter = 0;
+
+void setup() {
+  WiFi.begin(ssid, password);
+  while (WiFi.status() != WL_CONNECTED) {
+    delay(100);
+  }
+
+  lix.output(&ddp);
+  lix.begin();
+  lix.stop_animation();
+  lix.color_generator(ON, GENERATOR_GRADIENT, 0, 90, 5.0);
+}
+
+void loop() {
+  uint32_t t_now = millis();
+
+  if (t_now - last_frame >= 20) { // 50 FPS
+    last_frame = t_now;
+    lix.run();
+  }
+
+  if (t_now - last_count >= 1000) {
+    last_count = t_now;
+    lix.write(counter++);
+  }
+
+  yield();
+}
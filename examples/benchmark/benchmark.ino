@@ -0,0 +1,122 @@
+/*
+ * Lixie II "Benchmark" Example //////////////////////////////////////////////////////
+ * 
+ * Measures how long the animation ISR spends compositing each LED, without the time
+ * it takes to actually send the data out. Results are printed to the Serial Monitor
+ * at 115200 baud.
+ * 
+ * THE BUDGET:
+ * A WS2812B takes 30 microseconds to receive each LED's 24 bits, so compositing
+ * should never cost more than that per LED or the ISR spends longer building a
+ * frame than sending it. This is the number to beat on a 16MHz AVR - Espressif
+ * controllers should come in far below it.
+ * 
+ * KERNELS:
+ * Two compositing kernels give identical results: KERNEL_SCALAR works one color
+ * channel at a time, KERNEL_SWAR packs all three of an LED's channels into one
+ * 64-bit word and blends them together. Scalar is the default everywhere - if SWAR
+ * comes out ahead on your board, use lix.composite_kernel(KERNEL_SWAR). Both are
+ * timed here, and their output is compared LED for LED. extras/host
+ * ("make test") compares them far more thoroughly on a PC, over every pair of
+ * channel values, every mask weight, brightness level and dither step.
+ * 
+ * Displays are only composited again when something about them changes, so
+ * the last result shows what a frame costs when nothing is changing at all.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      6
+
+#define BUDGET_US_PER_LED 30.0
+#define FRAMES            250
+
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+// Swallows frames, so only compositing is timed. Can keep a copy of
+// one frame for comparing the kernels.
+class Null_Output : public Lixie_Output {
+  public:
+    CRGB *capture = NULL;
+    void show(CRGB *leds, uint16_t n_leds) {
+      if (capture != NULL) {
+        memcpy(capture, leds, n_leds * sizeof(CRGB));
+        capture = NULL;
+      }
+    }
+};
+Null_Output null_output;
+
+CRGB frame_scalar[NUM_DIGITS * 22];
+CRGB frame_swar[NUM_DIGITS * 22];
+
+float time_frames() {
+  uint32_t t_start = micros();
+  for (uint16_t i = 0; i < FRAMES; i++) {
+    lix.run();
+  }
+  uint32_t t_taken = micros() - t_start;
+  return t_taken / float(FRAMES) / (NUM_DIGITS * 22);
+}
+
+void report(const char* name, float us_per_led) {
+  Serial.print(name);
+  Serial.print(": ");
+  Serial.print(us_per_led);
+  Serial.print(" us per LED");
+  Serial.println(us_per_led <= BUDGET_US_PER_LED ? " (within budget)" : " (OVER BUDGET)");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  lix.begin();
+  lix.stop_animation(); // We'll call run() ourselves
+  lix.output(&null_output);
+
+  lix.color_generator(ON, GENERATOR_RAINBOW, 0, 40);
+  lix.color_all(OFF, CRGB(0, 3, 8));
+  lix.brightness(0.4);
+
+  // A 60 second crossfade barely moves from one frame to the next, so
+  // two frames about halfway through are a fair comparison of the kernels
+  lix.transition_time(60000);
+  lix.write(123456);
+  for (uint16_t i = 0; i < 1520; i++) {
+    lix.run();
+  }
+
+  lix.composite_kernel(KERNEL_SCALAR);
+  null_output.capture = frame_scalar;
+  lix.run();
+  lix.composite_kernel(KERNEL_SWAR);
+  null_output.capture = frame_swar;
+  lix.run();
+
+  bool exact = (memcmp(frame_scalar, frame_swar, sizeof(frame_scalar)) == 0);
+  Serial.println(exact ? "Kernels match" : "KERNELS DIFFER");
+
+  lix.color_all(ON, CRGB(255, 70, 7));
+  lix.write(654321); // Keeps a crossfade going for the whole test
+
+  for (uint8_t k = 0; k < 2; k++) {
+    Serial.println(k == 0 ? "\nKERNEL_SCALAR" : "\nKERNEL_SWAR");
+    lix.composite_kernel(k == 0 ? KERNEL_SCALAR : KERNEL_SWAR);
+    lix.dithering(false);
+    report("Crossfade", time_frames());
+
+    lix.dithering(true);
+    report("Crossfade + dithering", time_frames());
+  }
+
+  lix.dithering(false);
+  lix.transition_type(INSTANT);
+  lix.color_all(ON, CRGB(255, 70, 7)); // Stops the rainbow
+  lix.write(123456);
+  lix.run();
+  Serial.println();
+  report("Static", time_frames());
+}
+
+void loop() {
+}
@@ -0,0 +1,48 @@
+/*
+ * Lixie II "Color Generators" Example ////////////////////////////////////////////////
+ * 
+ * Instead of recoloring every LED from loop() with lix.color_all() or
+ * lix.gradient_rgb(), a layer can be handed to a color generator:
+ * 
+ * lix.color_generator(uint8_t layer, uint8_t type, uint8_t hue, [uint8_t hue_sep], [float rate]);
+ * 
+ * GENERATOR_HUE:      the whole layer in a single hue
+ * GENERATOR_GRADIENT: a gradient from hue (left) to hue + hue_sep (right)
+ * GENERATOR_RAINBOW:  each display hue_sep further around the color wheel than the last
+ * 
+ * "rate" is how many hue steps (out of 255) the colors travel every second, and the
+ * animation ISR takes care of the rest - loop() is free to do other things!
+ * 
+ * Any of the static color functions (lix.color_all(), lix.nixie(), etc.) turn the
+ * generator for that layer back off.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      4
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+void setup() {
+  lix.begin(); // Mandatory, sets up animation timer
+  lix.write(1234);
+}
+
+void loop() {
+  // Cycles the whole display around the color wheel once every ~5 seconds
+  lix.color_generator(ON, GENERATOR_HUE, 0, 0, 51.0);
+  delay(10000);
+
+  // Same gradient as the NTP clock example, but drifting on its own
+  lix.color_generator(ON, GENERATOR_GRADIENT, 0, 90, 10.0);
+  delay(10000);
+
+  // Static rainbow, one color per display
+  lix.color_generator(ON, GENERATOR_RAINBOW, 0, 32);
+  delay(10000);
+
+  // Generators work on the OFF layer too
+  lix.color_all(ON, CRGB(255, 255, 255));
+  lix.color_generator(OFF, GENERATOR_RAINBOW, 0, 32, -20.0);
+  delay(10000);
+  lix.color_all(OFF, CRGB(0, 0, 0));
+}
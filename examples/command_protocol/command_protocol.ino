@@ -0,0 +1,97 @@
+/*
+ * Lixie II "Command Protocol" Example ///////////////////////////////////////////////
+ * 
+ * Lixie II understands a small binary command protocol, so a display can be driven
+ * over Serial, UDP or anything else without writing your own parser:
+ * 
+ * lix.read_commands(Serial);         // Any Stream, call as often as you like
+ * lix.parse_packet(buffer, length);  // A whole packet, such as one from WiFiUDP
+ * 
+ * Packets are built with Lixie_Packet, which is plain C++ and can be used on a
+ * PC just as well as on another microcontroller:
+ * 
+ * uint8_t buf[LIXIE_MAX_PACKET];
+ * Lixie_Packet packet(buf, sizeof(buf));
+ * packet.write_value(1234);               // Staged...
+ * packet.color_all(ON, 255, 70, 7);
+ * packet.commit();                        // ...and shown
+ * Serial.write(buf, packet.finish());
+ * 
+ * This sketch loops packets straight back into the parser to check every command
+ * and measure how many updates per second the parser can keep up with, then listens
+ * for packets on the Serial port.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      4
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+uint8_t buf[LIXIE_MAX_PACKET];
+
+void check(const char* name, uint8_t expected, uint8_t result) {
+  Serial.print(name);
+  if (result == expected) {
+    Serial.println(": PASS");
+  }
+  else {
+    Serial.print(": FAIL, got ");
+    Serial.print(result);
+    Serial.print(" instead of ");
+    Serial.println(expected);
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  lix.begin(); // Mandatory, sets up animation timer
+
+  Lixie_Packet packet(buf, sizeof(buf));
+  packet.transition(CROSSFADE, 100);
+  packet.color_all(ON, 0, 255, 255);
+  packet.color_all(OFF, 0, 0, 8);
+  packet.special_pane(0, true, 255, 0, 0);
+  packet.brightness(200);
+  packet.write_value(1234);
+  packet.commit();
+  uint16_t len = packet.finish();
+  check("Full packet", LIXIE_OK, lix.parse_packet(buf, len));
+
+  packet.reset();
+  const uint8_t digits[4] = {1, 255, 128, 7};
+  packet.write_digits(digits, 4);
+  packet.special_pane(0, false);
+  packet.commit();
+  len = packet.finish();
+  check("Digits", LIXIE_OK, lix.parse_packet(buf, len));
+
+  // Each of these breaks one thing, then puts it back
+  buf[len - 1] ^= 0xFF;
+  check("Bad checksum", LIXIE_BAD_CHECKSUM, lix.parse_packet(buf, len));
+  buf[len - 1] ^= 0xFF;
+
+  buf[1] = LIXIE_PROTOCOL_VERSION + 1;
+  check("Bad version", LIXIE_BAD_VERSION, lix.parse_packet(buf, len));
+  buf[1] = LIXIE_PROTOCOL_VERSION;
+
+  check("Truncated", LIXIE_BAD_LENGTH, lix.parse_packet(buf, len - 2));
+  check("Intact again", LIXIE_OK, lix.parse_packet(buf, len));
+
+  // Throughput: write + commit, as fast as the parser will take them
+  const uint16_t updates = 1000;
+  uint32_t t_start = micros();
+  for (uint16_t i = 0; i < updates; i++) {
+    packet.reset();
+    packet.write_value(i);
+    packet.commit();
+    lix.parse_packet(buf, packet.finish());
+  }
+  uint32_t t_taken = micros() - t_start;
+
+  Serial.print("Updates per second: ");
+  Serial.println((updates * 1000000.0) / t_taken);
+}
+
+void loop() {
+  lix.read_commands(Serial);
+}
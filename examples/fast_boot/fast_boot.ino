@@ -0,0 +1,62 @@
+/*
+ * Lixie II "Fast Boot" Example //////////////////////////////////////////////////////
+ * 
+ * Rather than sitting dark until WiFi, NTP and your settings are all ready, a
+ * Lixie can show exactly what it was showing before the power went out:
+ * 
+ * lix.save_state(buffer, size);     // Returns bytes used, 0 if it didn't fit
+ * lix.restore_state(buffer, length);
+ * 
+ * (Any Print/Stream works too, such as a SPIFFS File: lix.save_state(file);)
+ * 
+ * The snapshot holds the numerals, ON/OFF colors (or color generators), special
+ * panes, brightness and transition settings. A 6-digit display in a single color
+ * takes well under 100 bytes. Restoring before lix.begin() shows it on the very
+ * first frame, with no transition.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#include <EEPROM.h>
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      4
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+#define STATE_SIZE      128
+
+uint8_t state[STATE_SIZE];
+uint16_t counter = 0;
+
+void setup() {
+#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
+  EEPROM.begin(STATE_SIZE);
+#endif
+
+  for (uint16_t i = 0; i < STATE_SIZE; i++) {
+    state[i] = EEPROM.read(i);
+  }
+
+  if (!lix.restore_state(state, STATE_SIZE)) {
+    lix.color_generator(ON, GENERATOR_RAINBOW, 0, 40); // First boot, nothing saved yet
+  }
+  lix.begin(); // Last frame is up already
+}
+
+void loop() {
+  lix.write(counter++);
+  delay(1000);
+
+  // Save once a minute to go easy on the EEPROM
+  if (counter % 60 == 0) {
+    uint16_t len = lix.save_state(state, STATE_SIZE);
+    for (uint16_t i = 0; i < len; i++) {
+#if defined(__AVR__)
+      EEPROM.update(i, state[i]); // Skips unchanged bytes
+#else
+      EEPROM.write(i, state[i]);
+#endif
+    }
+#if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
+    EEPROM.commit();
+#endif
+  }
+}
@@ -0,0 +1,61 @@
+/*
+ * Lixie II "Fields" Example /////////////////////////////////////////////////////////
+ * 
+ * Splits a 6 digit display into three independent fields - hours, minutes and
+ * seconds - each with its own alignment, padding, transition and colour:
+ * 
+ * uint8_t id = lix.add_field(uint16_t first_digit, uint16_t width, [uint8_t align], [bool zero_pad]);
+ * lix.write_field(uint8_t id, uint32_t value);
+ * lix.field_transition(uint8_t id, uint8_t type, uint16_t ms);
+ * lix.field_color(uint8_t id, uint8_t layer, CRGB col);
+ * 
+ * Digits count from the right, like everywhere else: the seconds field starts at
+ * digit 0. Writing a field only touches its own displays, and the others aren't
+ * even composited again - a field that isn't changing costs nothing to show.
+ * 
+ * lix.write() and value sources skip displays that belong to a field, and the
+ * number flows around them, so a field only ever shows what write_field() gave it.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      6
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+uint8_t hours, minutes, seconds;
+uint32_t t_last = 0;
+uint32_t elapsed = 0;
+
+void setup() {
+  lix.begin(); // Mandatory, sets up animation timer
+  lix.color_all(OFF, CRGB(0, 3, 8));
+
+  hours   = lix.add_field(4, 2);                    // Blank instead of a leading zero
+  minutes = lix.add_field(2, 2, ALIGN_RIGHT, true); // Always two digits
+  seconds = lix.add_field(0, 2, ALIGN_RIGHT, true);
+
+  lix.field_color(hours,   ON, CRGB(255, 70, 7));
+  lix.field_color(minutes, ON, CRGB(255, 70, 7));
+  lix.field_color(seconds, ON, CRGB(0, 100, 255));
+
+  lix.field_transition(hours,   CROSSFADE, 1000);
+  lix.field_transition(minutes, CROSSFADE, 500);
+  lix.field_transition(seconds, CROSSFADE, 150);
+}
+
+void loop() {
+  if (millis() - t_last >= 1000) {
+    t_last += 1000;
+
+    // Each field is only written when its value changes
+    if (elapsed % 3600 == 0) {
+      lix.write_field(hours, (elapsed / 3600) % 24);
+    }
+    if (elapsed % 60 == 0) {
+      lix.write_field(minutes, (elapsed / 60) % 60);
+    }
+    lix.write_field(seconds, elapsed % 60);
+
+    elapsed++;
+  }
+}
@@ -0,0 +1,65 @@
+/*
+ * Lixie II "Transition Events" Example //////////////////////////////////////////////
+ * 
+ * lix.on_event(callback) calls your function the moment something finishes:
+ * 
+ * EVENT_TRANSITION_END: the last write has fully faded in
+ * EVENT_COUNTDOWN_END:  lix.countdown_source() just reached zero
+ * 
+ * The callback runs inside the animation interrupt, so keep it short - no
+ * delay(), no Serial, just set a flag or write the next value. A write made
+ * from the callback starts fading on that very frame.
+ * 
+ * lix.wait() also blocks until the current transition is done, without
+ * rendering any frames of its own, and lix.transition_finished() lets you
+ * check without blocking at all.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      4
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+volatile uint16_t counter = 0;
+volatile bool countdown_over = false;
+bool countdown_started = false;
+
+void lixie_event(uint8_t event) {
+  if (event == EVENT_TRANSITION_END && counter < 100) {
+    lix.write(++counter); // Back-to-back crossfades, no gaps
+  }
+  else if (event == EVENT_COUNTDOWN_END) {
+    countdown_over = true;
+  }
+}
+
+void setup() {
+  lix.begin(); // Mandatory, sets up animation timer
+  lix.transition_time(200);
+
+  // Blocking version first
+  for (uint8_t i = 0; i < 10; i++) {
+    lix.write(i);
+    lix.wait();
+  }
+
+  // Then let the events drive it
+  lix.on_event(lixie_event);
+  lix.write(counter);
+}
+
+void loop() {
+  if (counter >= 100 && lix.transition_finished() && !countdown_started) {
+    countdown_started = true;
+    lix.countdown_source(10);
+  }
+
+  if (countdown_over) {
+    countdown_over = false;
+    countdown_started = false;
+    lix.stop_source();
+    lix.color_all(ON, CRGB(255, 0, 0));
+    counter = 0;
+    lix.write(counter);
+  }
+}
@@ -0,0 +1,52 @@
+/*
+ * Lixie II "Value Sources" Example //////////////////////////////////////////////////
+ * 
+ * Clocks, countdowns and counters don't need loop() at all - the animation ISR can
+ * keep count on its own, and only the displays whose numeral changes fade to the
+ * new value:
+ * 
+ * lix.clock_source(uint32_t seconds_since_midnight, [bool hour_12]);
+ * lix.countdown_source(uint32_t start, [uint16_t period_ms]);
+ * lix.counter_source([uint32_t start], [uint16_t period_ms]);
+ * 
+ * The display only redraws 50 times a second, so a period_ms under 20 still
+ * counts at the right rate, but skips some values on the way.
+ * 
+ * If you have a better clock somewhere (NTP, an RTC, GPS), hand it to
+ * lix.sync_source() every so often:
+ * 
+ * lix.sync_source(uint32_t value, [uint16_t phase_ms]);
+ * 
+ * phase_ms is how far into value the reference is, like the milliseconds of an
+ * NTP time. Without it, the reference could be anywhere in that period, so the
+ * display is only nudged once it falls outside of it. Being up to a period off
+ * is eased out over the following seconds, anything more is corrected at once.
+ * 
+ * lix.stop_source() hands the display back to lix.write() and friends.
+ */
+
+#include <Lixie_II.h>           // https://github.com/connornishijima/Lixie_II
+#define DATA_PIN        13      // Lixie DIN connects to this pin (D7 on Wemos)
+#define NUM_DIGITS      4
+Lixie_II lix(DATA_PIN, NUM_DIGITS);
+
+void setup() {
+  lix.begin(); // Mandatory, sets up animation timer
+  lix.nixie();
+}
+
+void loop() {
+  // Counts up 10 times a second
+  lix.counter_source(0, 100);
+  delay(10000);
+
+  // Ten second countdown
+  lix.countdown_source(10);
+  delay(12000);
+
+  // 12:59:50 PM, shown as HHMM on a 4 digit display
+  lix.clock_source((12 * 3600UL) + (59 * 60) + 50, true);
+  delay(20000);
+
+  lix.stop_source();
+}
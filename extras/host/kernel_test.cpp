@@ -0,0 +1,323 @@
+/*
+  kernel_test.cpp - Checks lixie_composite_swar() against the reference
+  lixie_composite_scalar(), then times both.
+
+  Every pair of ON/OFF channel values is composited at every mask value,
+  with rounding and with each dither step, then every mask value at every
+  brightness level for a set of edge case colours. Last come random walls
+  with fields, crossfades, generators and special panes. The two kernels
+  have to agree on every LED.
+*/
+
+#include "Lixie_Composite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } }while(0)
+
+// Test wall ----------------------------------------------------------------
+
+struct Wall{
+  std::vector<lixie_rgb> leds;
+  std::vector<lixie_rgb> col_on;
+  std::vector<lixie_rgb> col_off;
+  std::vector<uint8_t> mask_0;
+  std::vector<uint8_t> mask_1;
+  std::vector<lixie_rgb> gen_on;
+  std::vector<lixie_rgb> gen_off;
+  std::vector<uint8_t> x_offsets;
+  std::vector<uint8_t> special_panes_enabled; // bool, but std::vector<bool> has no data()
+  std::vector<lixie_rgb> special_panes_color;
+  std::vector<uint8_t> digit_field;
+  std::vector<uint8_t> digit_dirty;
+  lixie_frame frame;
+};
+
+static lixie_rgb rgb(uint8_t r, uint8_t g, uint8_t b){
+  lixie_rgb c = { r, g, b };
+  return c;
+}
+
+static lixie_rgb random_rgb(){
+  return rgb(rand(), rand(), rand());
+}
+
+// Everything off, no fields, no generators, full brightness, rounding
+static void wall_build(Wall &w, uint16_t n_digits, uint8_t leds_per_digit, uint8_t x_width){
+  uint32_t n_leds = (uint32_t)n_digits * leds_per_digit;
+  uint16_t max_x_pos = n_digits * x_width - 1;
+
+  w.leds.assign(n_leds, rgb(0, 0, 0));
+  w.col_on.assign(n_leds, rgb(0, 0, 0));
+  w.col_off.assign(n_leds, rgb(0, 0, 0));
+  w.mask_0.assign(n_leds, 0);
+  w.mask_1.assign(n_leds, 0);
+  w.gen_on.assign(max_x_pos + 1, rgb(0, 0, 0));
+  w.gen_off.assign(max_x_pos + 1, rgb(0, 0, 0));
+  w.x_offsets.assign(leds_per_digit, 0);
+  for(uint8_t i = 0; i < leds_per_digit; i++){
+    w.x_offsets[i] = (uint16_t)i * x_width / leds_per_digit;
+  }
+  w.special_panes_enabled.assign(n_digits, 0);
+  w.special_panes_color.assign(n_digits * 2, rgb(0, 0, 0));
+  w.digit_field.assign(n_digits, LIXIE_NO_FIELD);
+  w.digit_dirty.assign(n_digits, 1);
+
+  lixie_frame &f = w.frame;
+  memset(&f, 0, sizeof(f));
+  f.n_digits = n_digits;
+  f.leds_per_digit = leds_per_digit;
+  f.x_width = x_width;
+  f.max_x_pos = max_x_pos;
+  f.x_offsets = w.x_offsets.data();
+  f.special_leds[0] = 255;
+  f.special_leds[1] = 255;
+  f.leds = w.leds.data();
+  f.col_on = w.col_on.data();
+  f.col_off = w.col_off.data();
+  f.mask_0 = w.mask_0.data();
+  f.mask_1 = w.mask_1.data();
+  f.special_panes_enabled = (const bool*)w.special_panes_enabled.data();
+  f.special_panes_color = w.special_panes_color.data();
+  f.digit_field = w.digit_field.data();
+  f.digit_dirty = w.digit_dirty.data();
+  f.level = 256;
+}
+
+// Runs both kernels over the whole wall and compares every LED. what
+// describes the frame, for the first LED that differs.
+static bool kernels_match(Wall &w, const char *what){
+  lixie_frame &f = w.frame;
+  for(uint16_t d = 0; d < f.n_digits; d++){
+    lixie_composite_scalar(f, d);
+  }
+  std::vector<lixie_rgb> expected = w.leds;
+  for(uint16_t d = 0; d < f.n_digits; d++){
+    lixie_composite_swar(f, d);
+  }
+
+  for(size_t i = 0; i < expected.size(); i++){
+    const lixie_rgb &a = expected[i];
+    const lixie_rgb &b = w.leds[i];
+    if(a.r != b.r || a.g != b.g || a.b != b.b){
+      const lixie_rgb &on = f.col_on[i];
+      const lixie_rgb &off = f.col_off[i];
+      printf("  FAIL %s, LED %u: on %u,%u,%u off %u,%u,%u mask %u level %u dither %u count %u: scalar %u,%u,%u swar %u,%u,%u\n",
+             what, (unsigned)i, on.r, on.g, on.b, off.r, off.g, off.b, f.mask_0[i], f.level, f.dither, f.count,
+             a.r, a.g, a.b, b.r, b.g, b.b);
+      failures++;
+      return false;
+    }
+  }
+  return true;
+}
+
+// Rounding, then each of the 8 dither steps. Step (count + i) & 7 lands on
+// every LED once over 8 frames.
+static bool kernels_match_all_low_bits(Wall &w, const char *what){
+  w.frame.dither = false;
+  if(!kernels_match(w, what)){
+    return false;
+  }
+  w.frame.dither = true;
+  for(uint8_t count = 0; count < 8; count++){
+    w.frame.count = count;
+    if(!kernels_match(w, what)){
+      return false;
+    }
+  }
+  w.frame.dither = false;
+  return true;
+}
+
+// Exhaustive ---------------------------------------------------------------
+
+// All 65536 ON/OFF pairs of channel values, each lane different so
+// neighbouring lanes can't hide a carry from each other, at every mask value
+static void test_every_color_pair(){
+  Wall w;
+  wall_build(w, 4096, 16, 1); // Exactly 65536 LEDs, one per pair
+  for(uint32_t pair = 0; pair < 65536; pair++){
+    uint8_t a = pair >> 8;
+    uint8_t b = pair;
+    w.col_on[pair]  = rgb(a, b ^ 0x5A, b);
+    w.col_off[pair] = rgb(b, a ^ 0xA5, a);
+  }
+
+  bool ok = true;
+  for(uint16_t m = 0; m < 256 && ok; m++){
+    memset(w.mask_0.data(), m, w.mask_0.size());
+    ok = kernels_match_all_low_bits(w, "every color pair");
+  }
+  printf("Every color pair at every mask value:      %s\n", ok ? "ok" : "FAIL");
+}
+
+// Every mask value at every brightness level, so every pair of weights
+// the kernels can be handed, for colours at and around the edges. Each
+// display has its own mask value and every pair of edge colours.
+static void test_every_weight(){
+  const uint8_t edges[] = { 0, 1, 2, 127, 128, 129, 253, 254, 255 };
+  const uint8_t n_edges = sizeof(edges);
+
+  Wall w;
+  wall_build(w, 256, n_edges * n_edges, 1);
+  srand(31);
+  uint16_t i = 0;
+  for(uint16_t m = 0; m < 256; m++){
+    for(uint8_t on = 0; on < n_edges; on++){
+      for(uint8_t off = 0; off < n_edges; off++, i++){
+        uint8_t a = edges[on];
+        uint8_t b = edges[off];
+        w.col_on[i]  = (i & 1) ? rgb(a, b, a) : rgb(a, rand(), 255 - a);
+        w.col_off[i] = (i & 1) ? rgb(b, a, b) : rgb(b, rand(), 255 - b);
+        w.mask_0[i] = m;
+      }
+    }
+  }
+
+  bool ok = true;
+  for(uint16_t level = 0; level <= 256 && ok; level++){
+    w.frame.level = level;
+    ok = kernels_match_all_low_bits(w, "every weight");
+  }
+  printf("Every mask value at every level:           %s\n", ok ? "ok" : "FAIL");
+}
+
+// Random -------------------------------------------------------------------
+
+// Whole random walls, composited through lixie_composite_digits() so
+// special panes and dirty flags are covered as well
+static void test_random_walls(){
+  const uint8_t lixie_II_special_leds[2] = { 4, 17 };
+  srand(7);
+  bool ok = true;
+  uint32_t walls = 0;
+  for(; walls < 2000 && ok; walls++){
+    uint16_t n_digits = 1 + rand() % 40;
+    Wall w;
+    wall_build(w, n_digits, 22, 6);
+    lixie_frame &f = w.frame;
+
+    for(size_t i = 0; i < w.leds.size(); i++){
+      w.col_on[i] = random_rgb();
+      w.col_off[i] = random_rgb();
+      w.mask_0[i] = (rand() & 1) ? 255 : rand();
+      w.mask_1[i] = (rand() & 1) ? 0 : rand();
+    }
+    for(size_t x = 0; x < w.gen_on.size(); x++){
+      w.gen_on[x] = random_rgb();
+      w.gen_off[x] = random_rgb();
+    }
+    for(uint16_t d = 0; d < n_digits; d++){
+      w.special_panes_enabled[d] = (rand() % 4 == 0);
+      w.special_panes_color[d*2] = random_rgb();
+      w.special_panes_color[d*2+1] = random_rgb();
+      w.digit_field[d] = (rand() % 3 == 0) ? rand() % LIXIE_MAX_FIELDS : LIXIE_NO_FIELD;
+    }
+    if(rand() & 1){
+      f.special_leds[0] = lixie_II_special_leds[0];
+      f.special_leds[1] = lixie_II_special_leds[1];
+    }
+
+    f.current_mask = rand() & 1;
+    f.fade = (rand() % 4 == 0) ? (rand() & 1) * 256 : rand() % 257; // Often not fading at all
+    for(uint8_t fi = 0; fi < LIXIE_MAX_FIELDS; fi++){
+      f.field_mask[fi] = rand() & 1;
+      f.field_fade[fi] = rand() % 257;
+    }
+    f.level = (rand() & 1) ? 256 : rand() % 257;
+    f.gen_on = (rand() & 1) ? w.gen_on.data() : NULL;
+    f.gen_off = (rand() & 1) ? w.gen_off.data() : NULL;
+    f.dither = rand() & 1;
+    f.count = rand();
+
+    f.kernel = KERNEL_SCALAR;
+    memset(w.digit_dirty.data(), 1, n_digits);
+    CHECK(lixie_composite_digits(f, 0, n_digits));
+    std::vector<lixie_rgb> expected = w.leds;
+
+    f.kernel = KERNEL_SWAR;
+    memset(w.digit_dirty.data(), 1, n_digits);
+    CHECK(lixie_composite_digits(f, 0, n_digits));
+    ok = (memcmp(expected.data(), w.leds.data(), expected.size() * sizeof(lixie_rgb)) == 0);
+    CHECK(ok);
+
+    // Nothing dirty, nothing drawn
+    CHECK(!lixie_composite_digits(f, 0, n_digits));
+  }
+  printf("%4u random walls:                          %s\n", walls, ok ? "ok" : "FAIL");
+}
+
+// Timing -------------------------------------------------------------------
+
+// What a frame looks like while timing
+#define TIME_CROSSFADE  0 // Mid-crossfade with dithering on, nothing can be skipped
+#define TIME_STEADY     1 // Not fading, rounding
+#define TIME_GENERATOR  2 // Not fading, a generator on the ON layer
+
+// The largest Lixie II wall redrawn every frame on one kernel, the best
+// of a few runs so other work on the machine doesn't count. The
+// "benchmark" example times the kernels on a board itself.
+static double time_kernel(uint8_t kernel, uint8_t scene){
+  const uint16_t n_digits = 2978;
+  const uint32_t frames = 20;
+  Wall w;
+  wall_build(w, n_digits, 22, 6);
+  srand(1);
+  for(size_t i = 0; i < w.leds.size(); i++){
+    w.col_on[i] = random_rgb();
+    w.col_off[i] = random_rgb();
+    w.mask_0[i] = (rand() % 10 == 0) ? 255 : 0;
+    w.mask_1[i] = (rand() % 10 == 0) ? 255 : 0;
+  }
+  for(size_t x = 0; x < w.gen_on.size(); x++){
+    w.gen_on[x] = random_rgb();
+  }
+  lixie_frame &f = w.frame;
+  f.kernel = kernel;
+  f.dither = (scene == TIME_CROSSFADE);
+  f.gen_on = (scene == TIME_GENERATOR) ? w.gen_on.data() : NULL;
+
+  double best = 0;
+  for(uint8_t run = 0; run < 5; run++){
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(uint32_t n = 0; n < frames; n++){
+      f.fade = (scene == TIME_CROSSFADE) ? n % 257 : 256;
+      f.count++;
+      memset(w.digit_dirty.data(), 1, n_digits);
+      lixie_composite_digits(f, 0, n_digits);
+    }
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(end - start).count() / ((double)frames * w.leds.size());
+    if(run == 0 || ns < best){
+      best = ns;
+    }
+  }
+  return best;
+}
+
+static void time_kernels(){
+  const char *scenes[] = { "crossfade, dithered", "steady", "steady, generator" };
+  printf("%-20s %14s %14s\n", "ns/LED", "KERNEL_SCALAR", "KERNEL_SWAR");
+  for(uint8_t scene = TIME_CROSSFADE; scene <= TIME_GENERATOR; scene++){
+    double scalar = time_kernel(KERNEL_SCALAR, scene);
+    double swar = time_kernel(KERNEL_SWAR, scene);
+    printf("%-20s %14.2f %8.2f (%.2fx)\n", scenes[scene], scalar, swar, scalar / swar);
+  }
+}
+
+int main(){
+  test_every_color_pair();
+  test_every_weight();
+  test_random_walls();
+  time_kernels();
+
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
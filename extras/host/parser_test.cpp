@@ -0,0 +1,355 @@
+/*
+  parser_test.cpp - Builds command packets with Lixie_Packet and reads them
+  back with Lixie_Packet_Reader, corrupting them every way a serial line
+  might, then stages writes the way Lixie_II::parse_packet() does to check
+  that nothing reaches the displays before a COMMIT.
+*/
+
+#include "Lixie_Protocol.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } }while(0)
+
+static uint16_t count_commands(const uint8_t *buf, uint16_t len){
+  Lixie_Packet_Reader reader(buf, len);
+  uint16_t n = 0;
+  while(reader.next() != NULL){
+    n++;
+  }
+  return n;
+}
+
+// Round trip ---------------------------------------------------------------
+
+static void test_round_trip(){
+  uint8_t buf[LIXIE_MAX_PACKET];
+  Lixie_Packet packet(buf, sizeof(buf));
+  const uint8_t digits[4] = { 1, 255, 128, 7 };
+  packet.write_value(0xDEADBEEF);
+  packet.write_digits(digits, 4);
+  packet.color_all(1, 10, 20, 30);
+  packet.color_display(3, 0, 40, 50, 60);
+  packet.special_pane(2, true, 1, 2, 3, 4, 5, 6);
+  packet.brightness(200);
+  packet.transition(2, 1234);
+  packet.commit();
+  uint16_t len = packet.finish();
+  CHECK(len > 0);
+
+  Lixie_Packet_Reader reader(buf, len);
+  CHECK(reader.status() == LIXIE_OK);
+  const uint8_t *cmd;
+
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_WRITE_VALUE);
+  CHECK(cmd != NULL && cmd[1] == 0xDE && cmd[2] == 0xAD && cmd[3] == 0xBE && cmd[4] == 0xEF);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_WRITE_DIGITS);
+  CHECK(cmd != NULL && cmd[1] == 4 && memcmp(cmd + 2, digits, 4) == 0);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_COLOR_ALL && cmd[1] == 1 && cmd[2] == 10 && cmd[4] == 30);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_COLOR_DISPLAY && cmd[1] == 3 && cmd[5] == 60);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_SPECIAL_PANE && cmd[1] == 2 && cmd[2] == 1 && cmd[8] == 6);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_BRIGHTNESS && cmd[1] == 200);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_TRANSITION && cmd[1] == 2 && ((cmd[2] << 8) | cmd[3]) == 1234);
+  cmd = reader.next();
+  CHECK(cmd != NULL && cmd[0] == LIXIE_CMD_COMMIT);
+  CHECK(reader.next() == NULL);
+  CHECK(reader.next() == NULL);
+
+  // An empty packet is fine, it just does nothing
+  packet.reset();
+  len = packet.finish();
+  CHECK(len == LIXIE_PROTOCOL_OVERHEAD);
+  CHECK(Lixie_Packet_Reader(buf, len).status() == LIXIE_OK);
+  CHECK(count_commands(buf, len) == 0);
+
+  // Anything that doesn't fit is refused whole
+  packet.reset();
+  uint8_t many[LIXIE_MAX_PACKET];
+  memset(many, 1, sizeof(many));
+  packet.write_digits(many, LIXIE_MAX_PACKET - LIXIE_PROTOCOL_OVERHEAD - 1);
+  CHECK(packet.finish() == 0);
+  packet.reset();
+  packet.write_digits(many, LIXIE_MAX_PACKET - LIXIE_PROTOCOL_OVERHEAD - 2);
+  len = packet.finish();
+  CHECK(len == LIXIE_MAX_PACKET);
+  CHECK(count_commands(buf, len) == 1);
+}
+
+// Corruption ---------------------------------------------------------------
+
+// A random string of valid commands
+static uint16_t random_packet(uint8_t *buf, uint16_t size){
+  Lixie_Packet packet(buf, size);
+  uint8_t n = rand() % 12;
+  for(uint8_t i = 0; i < n; i++){
+    uint8_t digits[16];
+    for(uint8_t d = 0; d < sizeof(digits); d++){
+      digits[d] = rand();
+    }
+    switch(rand() % 8){
+      case 0: packet.write_value(rand()); break;
+      case 1: packet.write_digits(digits, rand() % sizeof(digits)); break;
+      case 2: packet.color_all(rand(), rand(), rand(), rand()); break;
+      case 3: packet.color_display(rand(), rand(), rand(), rand(), rand()); break;
+      case 4: packet.special_pane(rand(), rand() & 1, rand(), rand(), rand()); break;
+      case 5: packet.brightness(rand()); break;
+      case 6: packet.transition(rand(), rand()); break;
+      case 7: packet.commit(); break;
+    }
+  }
+  return packet.finish();
+}
+
+static void test_corruption(){
+  uint8_t buf[LIXIE_MAX_PACKET];
+  uint8_t bad[LIXIE_MAX_PACKET + 1];
+  uint32_t packets = 0;
+
+  srand(1);
+  for(uint16_t p = 0; p < 2000; p++){
+    uint16_t len = random_packet(buf, sizeof(buf));
+    if(len == 0){
+      continue; // Didn't fit
+    }
+    packets++;
+    CHECK(Lixie_Packet_Reader(buf, len).status() == LIXIE_OK);
+
+    // Any single byte flipped is caught: the header by its own checks,
+    // everything after it by the checksum
+    for(uint16_t i = 0; i < len; i++){
+      memcpy(bad, buf, len);
+      bad[i] ^= 1 << (rand() % 8);
+      Lixie_Packet_Reader reader(bad, len);
+      CHECK(reader.status() != LIXIE_OK);
+      CHECK(reader.next() == NULL);
+    }
+
+    // As is any packet cut short or run on
+    for(uint16_t cut = 0; cut < len; cut++){
+      CHECK(Lixie_Packet_Reader(buf, cut).status() != LIXIE_OK);
+    }
+    memcpy(bad, buf, len);
+    bad[len] = 0;
+    CHECK(Lixie_Packet_Reader(bad, len + 1).status() == LIXIE_BAD_LENGTH);
+  }
+  CHECK(packets > 1000);
+
+  // Each error for what it is
+  Lixie_Packet packet(buf, sizeof(buf));
+  packet.write_value(1234);
+  packet.commit();
+  uint16_t len = packet.finish();
+
+  memcpy(bad, buf, len);
+  bad[0] = 'X';
+  CHECK(Lixie_Packet_Reader(bad, len).status() == LIXIE_BAD_HEADER);
+  CHECK(Lixie_Packet_Reader(buf, LIXIE_PROTOCOL_OVERHEAD - 1).status() == LIXIE_BAD_HEADER);
+  memcpy(bad, buf, len);
+  bad[1] = LIXIE_PROTOCOL_VERSION + 1;
+  CHECK(Lixie_Packet_Reader(bad, len).status() == LIXIE_BAD_VERSION);
+  CHECK(Lixie_Packet_Reader(buf, len - 1).status() == LIXIE_BAD_LENGTH);
+  memcpy(bad, buf, len);
+  bad[len - 1] ^= 0xFF;
+  CHECK(Lixie_Packet_Reader(bad, len).status() == LIXIE_BAD_CHECKSUM);
+
+  // Commands that are unknown or run off the end, with a good checksum
+  const uint8_t unknown[] = { LIXIE_PROTOCOL_MAGIC, LIXIE_PROTOCOL_VERSION, 0, 1, 0x7F, 0x7F };
+  CHECK(Lixie_Packet_Reader(unknown, sizeof(unknown)).status() == LIXIE_BAD_COMMAND);
+  const uint8_t short_value[] = { LIXIE_PROTOCOL_MAGIC, LIXIE_PROTOCOL_VERSION, 0, 3, LIXIE_CMD_WRITE_VALUE, 0, 0, LIXIE_CMD_WRITE_VALUE };
+  CHECK(Lixie_Packet_Reader(short_value, sizeof(short_value)).status() == LIXIE_BAD_COMMAND);
+  const uint8_t no_count[] = { LIXIE_PROTOCOL_MAGIC, LIXIE_PROTOCOL_VERSION, 0, 1, LIXIE_CMD_WRITE_DIGITS, LIXIE_CMD_WRITE_DIGITS };
+  CHECK(Lixie_Packet_Reader(no_count, sizeof(no_count)).status() == LIXIE_BAD_COMMAND);
+  const uint8_t long_count[] = { LIXIE_PROTOCOL_MAGIC, LIXIE_PROTOCOL_VERSION, 0, 3, LIXIE_CMD_WRITE_DIGITS, 2, 5, LIXIE_CMD_WRITE_DIGITS ^ 2 ^ 5 };
+  CHECK(Lixie_Packet_Reader(long_count, sizeof(long_count)).status() == LIXIE_BAD_COMMAND);
+
+  printf("%u random packets, every corruption caught\n", (unsigned)packets);
+}
+
+// Staging ------------------------------------------------------------------
+
+// Stands in for Lixie_II: packets go through parse(), which stages writes
+// exactly as parse_packet() does, and shown[] (display 0 on the right,
+// 128 for a blank) only ever changes on a COMMIT
+struct Display{
+  std::vector<uint8_t> shown;
+  std::vector<uint8_t> staged_buffer;
+  Lixie_Staged_Digits staged;
+  uint16_t commits;
+
+  Display(uint16_t n_digits){
+    shown.assign(n_digits, 128);
+    staged_buffer.resize(n_digits);
+    staged = Lixie_Staged_Digits(staged_buffer.data(), n_digits);
+    commits = 0;
+  }
+
+  // Like Lixie_II::push_digit()
+  void push_digit(uint8_t number){
+    for(size_t d = shown.size() - 1; d > 0; d--){
+      shown[d] = shown[d - 1];
+    }
+    shown[0] = number;
+  }
+
+  uint8_t parse(const uint8_t *buf, uint16_t len){
+    Lixie_Packet_Reader reader(buf, len);
+    const uint8_t *cmd;
+    while((cmd = reader.next()) != NULL){
+      switch(cmd[0]){
+        case LIXIE_CMD_WRITE_VALUE:
+          staged.write_value(((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4]);
+          break;
+        case LIXIE_CMD_WRITE_DIGITS:
+          staged.write_digits(cmd + 2, cmd[1]);
+          break;
+        case LIXIE_CMD_COMMIT:
+          if(staged.pending()){
+            staged.done();
+            shown.assign(shown.size(), 128);
+            for(uint16_t d = 0; d < staged.count(); d++){
+              push_digit(staged.digit(d));
+            }
+            commits++;
+          }
+          break;
+      }
+    }
+    return reader.status();
+  }
+
+  // Left to right, as the displays read
+  bool shows(const char *expected){
+    size_t n = strlen(expected);
+    if(n != shown.size()){
+      return false;
+    }
+    for(size_t i = 0; i < n; i++){
+      uint8_t d = shown[n - 1 - i];
+      char c = (d < 10) ? '0' + d : (d == 128) ? '_' : (d == 255) ? '.' : '?';
+      if(c != expected[i]){
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+static void test_staging(){
+  uint8_t buf[LIXIE_MAX_PACKET];
+  Lixie_Packet packet(buf, sizeof(buf));
+  Display lix(6);
+
+  // A write on its own stays staged, however many packets it waits for
+  packet.write_value(1234);
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("______"));
+  CHECK(lix.staged.pending());
+  packet.reset();
+  packet.brightness(10);
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("______"));
+
+  uint8_t commit[LIXIE_PROTOCOL_OVERHEAD + 1];
+  Lixie_Packet commit_packet(commit, sizeof(commit));
+  commit_packet.commit();
+  uint16_t commit_len = commit_packet.finish();
+  CHECK(lix.parse(commit, commit_len) == LIXIE_OK);
+  CHECK(lix.shows("__1234"));
+  CHECK(!lix.staged.pending());
+
+  // A COMMIT with nothing staged shows nothing new
+  CHECK(lix.parse(commit, commit_len) == LIXIE_OK);
+  CHECK(lix.commits == 1);
+
+  // The last write before a COMMIT wins, earlier ones are never seen
+  packet.reset();
+  packet.write_value(999999);
+  const uint8_t digits[4] = { 1, 255, 128, 7 };
+  packet.write_digits(digits, 4);
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("__1234"));
+  CHECK(lix.parse(commit, commit_len) == LIXIE_OK);
+  CHECK(lix.shows("__1._7"));
+
+  // A bad packet stages nothing
+  packet.reset();
+  packet.write_value(5);
+  packet.commit();
+  uint16_t len = packet.finish();
+  buf[len - 1] ^= 1;
+  CHECK(lix.parse(buf, len) == LIXIE_BAD_CHECKSUM);
+  CHECK(!lix.staged.pending());
+  CHECK(lix.shows("__1._7"));
+  buf[len - 1] ^= 1;
+  CHECK(lix.parse(buf, len) == LIXIE_OK);
+  CHECK(lix.shows("_____5"));
+
+  // Zero is one digit, and the largest value fills past the displays
+  packet.reset();
+  packet.write_value(0);
+  packet.commit();
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("_____0"));
+  packet.reset();
+  packet.write_value(4294967295UL);
+  packet.commit();
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("967295"));
+
+  // More digits than displays keeps the newest, as pushing them would
+  uint8_t many[100];
+  for(uint8_t i = 0; i < sizeof(many); i++){
+    many[i] = i % 10;
+  }
+  packet.reset();
+  packet.write_digits(many, sizeof(many));
+  packet.commit();
+  CHECK(lix.parse(buf, packet.finish()) == LIXIE_OK);
+  CHECK(lix.shows("456789"));
+
+  // Every staged count from none to well past the buffer, on one display
+  // and on many
+  const uint16_t widths[] = { 1, 2, 6, 37 };
+  for(size_t w = 0; w < sizeof(widths) / sizeof(widths[0]); w++){
+    Display wall(widths[w]);
+    for(uint8_t n = 0; n < sizeof(many); n++){
+      packet.reset();
+      packet.write_digits(many, n);
+      packet.commit();
+      CHECK(wall.parse(buf, packet.finish()) == LIXIE_OK);
+
+      uint16_t kept = (n < widths[w]) ? n : widths[w];
+      CHECK(wall.staged.count() == kept);
+      for(uint16_t d = 0; d < widths[w]; d++){
+        uint8_t expected = (d < kept) ? many[n - 1 - d] : 128;
+        CHECK(wall.shown[d] == expected);
+      }
+    }
+  }
+
+  // No buffer at all still parses, it just has nothing to show
+  Lixie_Staged_Digits none;
+  none.write_value(42);
+  CHECK(none.pending());
+  CHECK(none.count() == 0);
+}
+
+int main(){
+  test_round_trip();
+  test_corruption();
+  test_staging();
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
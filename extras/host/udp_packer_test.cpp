@@ -0,0 +1,225 @@
+/*
+  udp_packer_test.cpp - Sends DDP and E1.31 frames through
+  Lixie_UDP_Packer to a local UDP listener, which stands in for a pixel
+  controller: it decodes each packet the way a receiver would and
+  rebuilds the frame, which has to match what was sent.
+*/
+
+#include "Lixie_UDP_Packer.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+static int failures = 0;
+
+#define CHECK(cond) do{ if(!(cond)){ printf("  FAIL %s:%d: %s\n", __FILE__, __LINE__, #cond); failures++; } }while(0)
+
+// Listener stand-in --------------------------------------------------------
+
+struct Listener{
+  int sock;
+  uint16_t port;
+  std::vector<uint8_t> frame;
+  int packets;
+  int pushes;
+  uint8_t ddp_sequence;
+  int e131_sequence;               // This frame's, or -1 before its first packet
+  std::vector<int> e131_universes; // Last sequence seen on each universe, kept across frames
+};
+
+static void listener_open(Listener &l){
+  l.sock = socket(AF_INET, SOCK_DGRAM, 0);
+  int rcvbuf = 1 << 20;
+  setsockopt(l.sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+  
+  sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0; // Any free port
+  if(bind(l.sock, (sockaddr*)&addr, sizeof(addr)) != 0){
+    perror("bind");
+    exit(1);
+  }
+  socklen_t addr_len = sizeof(addr);
+  getsockname(l.sock, (sockaddr*)&addr, &addr_len);
+  l.port = ntohs(addr.sin_port);
+  
+  timeval timeout = { 1, 0 };
+  setsockopt(l.sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+}
+
+static void listener_reset(Listener &l){
+  l.frame.clear();
+  l.packets = 0;
+  l.pushes = 0;
+  l.ddp_sequence = 0;
+  l.e131_sequence = -1;
+}
+
+static void decode_ddp(Listener &l, const uint8_t *p, int n){
+  CHECK(n >= LIXIE_DDP_HEADER_LEN);
+  CHECK((p[0] & 0xC0) == 0x40); // Version 1
+  CHECK(p[2] == 0x0B);          // RGB, 8 bits
+  uint32_t offset = ((uint32_t)p[4] << 24) | ((uint32_t)p[5] << 16) | (p[6] << 8) | p[7];
+  uint16_t len = (p[8] << 8) | p[9];
+  CHECK(len == n - LIXIE_DDP_HEADER_LEN);
+  CHECK(len <= LIXIE_DDP_MAX_DATA);
+  CHECK(p[1] >= 1 && p[1] <= 15);
+  if(l.packets > 1){
+    CHECK(p[1] == l.ddp_sequence); // One sequence number per frame
+  }
+  l.ddp_sequence = p[1];
+  
+  if(l.frame.size() < offset + len){
+    l.frame.resize(offset + len);
+  }
+  memcpy(&l.frame[offset], p + LIXIE_DDP_HEADER_LEN, len);
+  if(p[0] & 0x01){
+    l.pushes++;
+  }
+}
+
+static void decode_e131(Listener &l, const uint8_t *p, int n, uint16_t first_universe){
+  CHECK(n >= LIXIE_E131_HEADER_LEN);
+  CHECK(memcmp(p + 4, "ASC-E1.17", 9) == 0);
+  CHECK(p[21] == 0x04 && p[43] == 0x02 && p[117] == 0x02);
+  
+  // Every PDU length counts from its own start to the end of the packet
+  CHECK((((p[16] & 0x0F) << 8) | p[17]) == n - 16);
+  CHECK((((p[38] & 0x0F) << 8) | p[39]) == n - 38);
+  CHECK((((p[115] & 0x0F) << 8) | p[116]) == n - 115);
+  
+  uint16_t count = ((p[123] << 8) | p[124]) - 1; // Less the start code
+  CHECK(count == n - LIXIE_E131_HEADER_LEN);
+  CHECK(count <= LIXIE_E131_MAX_DATA);
+  CHECK(p[125] == 0x00); // Start code
+  
+  uint16_t universe = (p[113] << 8) | p[114];
+  CHECK(universe >= first_universe);
+  
+  // Every packet of a frame shares one sequence number, and each universe
+  // sees it go up by exactly one from frame to frame
+  if(l.e131_sequence >= 0){
+    CHECK(p[111] == l.e131_sequence);
+  }
+  l.e131_sequence = p[111];
+  size_t u = universe - first_universe;
+  if(l.e131_universes.size() <= u){
+    l.e131_universes.resize(u + 1, -1);
+  }
+  if(l.e131_universes[u] >= 0){
+    CHECK(p[111] == (uint8_t)(l.e131_universes[u] + 1));
+  }
+  l.e131_universes[u] = p[111];
+  size_t offset = (universe - first_universe) * LIXIE_E131_MAX_DATA;
+  if(l.frame.size() < offset + count){
+    l.frame.resize(offset + count);
+  }
+  memcpy(&l.frame[offset], p + LIXIE_E131_HEADER_LEN, count);
+}
+
+static void listener_receive(Listener &l, int expected, uint8_t protocol, uint16_t first_universe){
+  uint8_t buf[2048];
+  for(int i = 0; i < expected; i++){
+    int n = recv(l.sock, buf, sizeof(buf), 0);
+    CHECK(n > 0);
+    if(n <= 0){
+      return;
+    }
+    l.packets++;
+    if(protocol == LIXIE_E131){
+      decode_e131(l, buf, n, first_universe);
+    }
+    else{
+      decode_ddp(l, buf, n);
+    }
+  }
+}
+
+// Sender ------------------------------------------------------------------
+
+static int send_frame(int sock, uint16_t port, Lixie_UDP_Packer &packer, const uint8_t *data, uint32_t len){
+  sockaddr_in dest;
+  memset(&dest, 0, sizeof(dest));
+  dest.sin_family = AF_INET;
+  dest.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  dest.sin_port = htons(port);
+  
+  uint8_t packet[LIXIE_UDP_MAX_HEADER + LIXIE_DDP_MAX_DATA];
+  uint8_t *header = packet;
+  uint16_t header_len;
+  const uint8_t *chunk;
+  uint16_t chunk_len;
+  int sent = 0;
+  
+  packer.start(data, len);
+  while(packer.next(header, header_len, chunk, chunk_len)){
+    memcpy(packet + header_len, chunk, chunk_len);
+    sendto(sock, packet, header_len + chunk_len, 0, (sockaddr*)&dest, sizeof(dest));
+    sent++;
+  }
+  return sent;
+}
+
+static void test_frame(Listener &l, int sock, uint8_t protocol, uint16_t n_leds){
+  uint16_t universe = 7;
+  Lixie_UDP_Packer packer(protocol, universe);
+  std::vector<uint8_t> frame(n_leds * 3);
+  
+  // Three frames, so sequence numbers get checked across frames too
+  l.e131_universes.clear();
+  for(int f = 0; f < 3; f++){
+    for(size_t i = 0; i < frame.size(); i++){
+      frame[i] = rand();
+    }
+    listener_reset(l);
+    int sent = send_frame(sock, l.port, packer, frame.data(), frame.size());
+    
+    uint16_t max_data = (protocol == LIXIE_E131) ? LIXIE_E131_MAX_DATA : LIXIE_DDP_MAX_DATA;
+    CHECK(sent == (int)((frame.size() + max_data - 1) / max_data));
+    
+    listener_receive(l, sent, protocol, universe);
+    CHECK(l.packets == sent);
+    CHECK(l.frame == frame);
+    if(protocol == LIXIE_DDP){
+      CHECK(l.pushes == 1); // Only the last packet of a frame
+    }
+  }
+  
+  printf("%-5s %5u LEDs: %s\n", (protocol == LIXIE_E131) ? "E1.31" : "DDP", n_leds, failures ? "FAIL" : "ok");
+}
+
+int main(){
+  Listener l;
+  listener_open(l);
+  int sock = socket(AF_INET, SOCK_DGRAM, 0);
+  
+  // 1 LED, one display, a 6 digit clock, a frame that splits unevenly,
+  // the last frame under 64KB and the largest wall Lixie_II allows
+  const uint16_t sizes[] = { 1, 22, 132, 661, 21845, 21846, 65520 };
+  for(uint8_t protocol = LIXIE_DDP; protocol <= LIXIE_E131; protocol++){
+    for(size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+      test_frame(l, sock, protocol, sizes[s]);
+    }
+  }
+  
+  // Unchanged frames hash the same, any change doesn't
+  uint8_t a[132 * 3];
+  memset(a, 40, sizeof(a));
+  uint32_t h = lixie_frame_hash(a, sizeof(a));
+  CHECK(h == lixie_frame_hash(a, sizeof(a)));
+  a[200] ^= 1;
+  CHECK(h != lixie_frame_hash(a, sizeof(a)));
+  
+  close(sock);
+  close(l.sock);
+  printf("%s\n", failures ? "FAILED" : "PASSED");
+  return failures ? 1 : 0;
+}
@@ -0,0 +1,282 @@
+/*
+  wall_bench.cpp - Composites large walls of Lixie IIs on a host, on one
+  thread and then on a pool of them sharing each frame's tiles the way
+  both cores of an ESP32 do. Every display is redrawn every frame (a
+  crossfade with dithering on), and every thread count has to produce the
+  same LEDs as one thread does.
+
+  ./wall_bench [frames]
+*/
+
+#include "Lixie_Composite.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Lixie II layout, as in Lixie_II.cpp
+const uint8_t lixie_II_x_offsets[22] = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5 };
+const uint8_t lixie_II_leds = 22;
+const uint8_t lixie_II_x_width = 6;
+const uint8_t lixie_II_special_leds[2] = { 4, 17 };
+
+// Wall buffers -------------------------------------------------------------
+
+struct Wall{
+  std::vector<lixie_rgb> leds;
+  std::vector<lixie_rgb> col_on;
+  std::vector<lixie_rgb> col_off;
+  std::vector<uint8_t> mask_0;
+  std::vector<uint8_t> mask_1;
+  std::vector<lixie_rgb> gen_on;
+  std::vector<uint8_t> special_panes_enabled; // bool, but std::vector<bool> has no data()
+  std::vector<lixie_rgb> special_panes_color;
+  std::vector<uint8_t> digit_field;
+  std::vector<uint8_t> digit_dirty;
+  lixie_frame frame;
+};
+
+static lixie_rgb random_rgb(){
+  lixie_rgb c = { (uint8_t)rand(), (uint8_t)rand(), (uint8_t)rand() };
+  return c;
+}
+
+// Random numerals on both masks, a rainbow generator on the ON layer and
+// one field, so every branch of the kernels is taken
+static void wall_build(Wall &w, uint16_t n_digits){
+  uint16_t n_leds = n_digits * lixie_II_leds;
+  uint16_t max_x_pos = n_digits * lixie_II_x_width - 1;
+  srand(n_digits);
+
+  w.leds.assign(n_leds, lixie_rgb());
+  w.col_on.resize(n_leds);
+  w.col_off.resize(n_leds);
+  w.mask_0.resize(n_leds);
+  w.mask_1.resize(n_leds);
+  for(uint16_t i = 0; i < n_leds; i++){
+    w.col_on[i] = random_rgb();
+    w.col_off[i] = random_rgb();
+    w.mask_0[i] = (rand() % 10 == 0) ? 255 : 0;
+    w.mask_1[i] = (rand() % 10 == 0) ? 255 : 0;
+  }
+  w.gen_on.resize(max_x_pos + 1);
+  for(uint16_t x = 0; x <= max_x_pos; x++){
+    w.gen_on[x] = random_rgb();
+  }
+
+  w.special_panes_enabled.resize(n_digits);
+  w.special_panes_color.resize(n_digits * 2);
+  w.digit_field.assign(n_digits, LIXIE_NO_FIELD);
+  w.digit_dirty.assign(n_digits, 1);
+  for(uint16_t d = 0; d < n_digits; d++){
+    w.special_panes_enabled[d] = (d % 7 == 0);
+    w.special_panes_color[d*2] = random_rgb();
+    w.special_panes_color[d*2+1] = random_rgb();
+  }
+  for(uint16_t d = n_digits / 2; d < n_digits / 2 + 6; d++){
+    w.digit_field[d] = 0;
+  }
+
+  lixie_frame &f = w.frame;
+  memset(&f, 0, sizeof(f));
+  f.n_digits = n_digits;
+  f.leds_per_digit = lixie_II_leds;
+  f.x_width = lixie_II_x_width;
+  f.max_x_pos = max_x_pos;
+  f.x_offsets = lixie_II_x_offsets;
+  f.special_leds[0] = lixie_II_special_leds[0];
+  f.special_leds[1] = lixie_II_special_leds[1];
+  f.leds = w.leds.data();
+  f.col_on = w.col_on.data();
+  f.col_off = w.col_off.data();
+  f.mask_0 = w.mask_0.data();
+  f.mask_1 = w.mask_1.data();
+  f.special_panes_enabled = (const bool*)w.special_panes_enabled.data();
+  f.special_panes_color = w.special_panes_color.data();
+  f.digit_field = w.digit_field.data();
+  f.digit_dirty = w.digit_dirty.data();
+  f.kernel = KERNEL_SWAR;
+  f.level = 256;
+  f.gen_on = w.gen_on.data();
+  f.dither = true;
+}
+
+// What animate() changes between frames
+static void wall_next_frame(Wall &w, uint32_t n){
+  lixie_frame &f = w.frame;
+  f.fade = n % 257;
+  f.field_mask[0] = (n / 50) & 1;
+  f.field_fade[0] = (n * 3) % 257;
+  f.count++;
+  memset(w.digit_dirty.data(), 1, w.digit_dirty.size());
+}
+
+static uint64_t wall_hash(const Wall &w, uint64_t hash){
+  const uint8_t *data = (const uint8_t*)w.leds.data();
+  size_t len = w.leds.size() * sizeof(lixie_rgb);
+  for(size_t i = 0; i < len; i++){
+    hash = (hash ^ data[i]) * 1099511628211ULL;
+  }
+  return hash;
+}
+
+// Thread pool --------------------------------------------------------------
+
+// Helpers sleep until composite() hands them a frame, then claim tiles
+// alongside the calling thread. composite() returns once every helper is
+// done, so nothing reads the LEDs while they're still being drawn.
+class Tile_Pool{
+  public:
+    Tile_Pool(unsigned helpers){
+      frame = NULL;
+      generation = 0;
+      busy = 0;
+      helper_any = false;
+      quit = false;
+      for(unsigned i = 0; i < helpers; i++){
+        threads.push_back(std::thread(&Tile_Pool::helper, this));
+      }
+    }
+
+    ~Tile_Pool(){
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        quit = true;
+      }
+      wake.notify_all();
+      for(size_t i = 0; i < threads.size(); i++){
+        threads[i].join();
+      }
+    }
+
+    bool composite(lixie_frame &f){
+      if(threads.empty()){
+        return lixie_composite_digits(f, 0, f.n_digits);
+      }
+      {
+        std::lock_guard<std::mutex> guard(lock);
+        f.next_tile = 0;
+        frame = &f;
+        generation++;
+        busy = threads.size();
+        helper_any = false;
+      }
+      wake.notify_all();
+      bool any = lixie_composite_tiles(f);
+
+      std::unique_lock<std::mutex> guard(lock);
+      finished.wait(guard, [this]{ return busy == 0; });
+      return any || helper_any;
+    }
+
+  private:
+    void helper(){
+      unsigned seen = 0;
+      for(;;){
+        lixie_frame *f;
+        {
+          std::unique_lock<std::mutex> guard(lock);
+          wake.wait(guard, [&]{ return quit || generation != seen; });
+          if(quit){
+            return;
+          }
+          seen = generation;
+          f = frame;
+        }
+        bool any = lixie_composite_tiles(*f);
+        {
+          std::lock_guard<std::mutex> guard(lock);
+          helper_any = helper_any || any;
+          busy--;
+        }
+        finished.notify_one();
+      }
+    }
+
+    std::vector<std::thread> threads;
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable finished;
+    lixie_frame *frame;
+    unsigned generation;
+    unsigned busy;
+    bool helper_any;
+    bool quit;
+};
+
+// Benchmark ----------------------------------------------------------------
+
+struct Result{
+  double us_per_frame;
+  uint64_t hash;
+};
+
+static Result run(uint16_t n_digits, unsigned threads, uint32_t frames){
+  Wall w;
+  wall_build(w, n_digits);
+  Tile_Pool pool(threads - 1);
+
+  Result r;
+  r.hash = 1469598103934665603ULL;
+  double total_us = 0;
+  for(uint32_t n = 0; n < frames; n++){
+    wall_next_frame(w, n);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    pool.composite(w.frame);
+    std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+    total_us += std::chrono::duration<double, std::micro>(end - start).count();
+    r.hash = wall_hash(w, r.hash);
+  }
+  r.us_per_frame = total_us / frames;
+  return r;
+}
+
+int main(int argc, char **argv){
+  uint32_t frames = (argc > 1) ? strtoul(argv[1], NULL, 10) : 200;
+  if(frames < 1){
+    frames = 1;
+  }
+
+  // Always try two threads, so the pool is checked even on one CPU
+  unsigned max_threads = std::thread::hardware_concurrency();
+  if(max_threads < 2){
+    max_threads = 2;
+  }
+  if(max_threads > LIXIE_MAX_CORES){
+    max_threads = LIXIE_MAX_CORES;
+  }
+
+  // 2978 is the most Lixie IIs that fit in LIXIE_MAX_LEDS
+  const uint16_t walls[] = { 1000, 2000, 2978 };
+  int failures = 0;
+
+  printf("%u frames each, %u CPUs\n", frames, std::thread::hardware_concurrency());
+  printf("%8s %8s %8s %12s %8s\n", "digits", "LEDs", "threads", "us/frame", "speedup");
+  for(size_t wall = 0; wall < sizeof(walls) / sizeof(walls[0]); wall++){
+    uint16_t n_digits = walls[wall];
+    Result single = run(n_digits, 1, frames);
+    printf("%8u %8u %8u %12.1f %8.2f\n", n_digits, n_digits * lixie_II_leds, 1, single.us_per_frame, 1.0);
+
+    for(unsigned threads = 2; threads <= max_threads; threads = (threads < max_threads && threads * 2 > max_threads) ? max_threads : threads * 2){
+      Result r = run(n_digits, threads, frames);
+      bool same = (r.hash == single.hash);
+      printf("%8u %8u %8u %12.1f %8.2f%s\n", n_digits, n_digits * lixie_II_leds, threads,
+             r.us_per_frame, single.us_per_frame / r.us_per_frame, same ? "" : "  FAIL: LEDs differ from 1 thread");
+      if(!same){
+        failures++;
+      }
+    }
+  }
+
+  if(failures){
+    printf("%d FAILED\n", failures);
+    return 1;
+  }
+  printf("All thread counts match\n");
+  return 0;
+}
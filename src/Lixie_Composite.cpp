@@ -0,0 +1,229 @@
+/*
+  Lixie_Composite.cpp - Blends the ON and OFF layers of a wall of displays
+  into its LEDs
+
+  Released under the GPLv3 License
+*/
+
+#include "Lixie_Composite.h"
+
+#if !defined(ARDUINO)
+  #define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+// Temporal dithering spreads the low 8 bits of each 16-bit channel over
+// 8 frames, in bit-reversed order so the error never builds up for long
+const uint8_t dither_steps[8] = { 16, 144, 80, 208, 48, 176, 112, 240 };
+
+// The masks and fade a display is currently drawn with - its field's, or the global ones
+struct digit_masks{
+  uint16_t fade;
+  const uint8_t *from;
+  const uint8_t *to;
+};
+
+static inline digit_masks masks_for_digit(const lixie_frame &frame, uint16_t digit_index){
+  digit_masks dm;
+  uint8_t mask_index = frame.current_mask;
+  dm.fade = frame.fade;
+
+  uint8_t field = frame.digit_field[digit_index];
+  if(field != LIXIE_NO_FIELD){
+    mask_index = frame.field_mask[field];
+    dm.fade = frame.field_fade[field];
+  }
+
+  dm.from = (mask_index == 0) ? frame.mask_0 : frame.mask_1;
+  dm.to   = (mask_index == 0) ? frame.mask_1 : frame.mask_0;
+  return dm;
+}
+
+// Mask weights for LED i, which both sum to frame.level or less. Masks are
+// almost always 0 or 255, so last_m saves recomputing them most of the time.
+static inline void led_weights(const lixie_frame &frame, const digit_masks &dm, uint16_t i, uint16_t &last_m, uint16_t &w_on, uint16_t &w_off){
+  uint16_t m = ((uint16_t)dm.from[i]*(256-dm.fade) + (uint16_t)dm.to[i]*dm.fade) >> 8;
+  m += m >> 7; // 0-255 -> 0-256
+  if(m != last_m){
+    last_m = m;
+    w_on  = ((uint32_t)m * frame.level) >> 8;
+    w_off = ((uint32_t)(256-m) * frame.level) >> 8;
+  }
+}
+
+static inline void led_colors(const lixie_frame &frame, uint16_t i, uint16_t x_base, uint8_t pcb_index, lixie_rgb &c_on, lixie_rgb &c_off){
+  c_on = frame.col_on[i];
+  c_off = frame.col_off[i];
+  if(frame.gen_on != NULL || frame.gen_off != NULL){
+    uint16_t x_pos = x_base - pgm_read_byte(&frame.x_offsets[pcb_index]);
+    if(frame.gen_on != NULL){
+      c_on = frame.gen_on[x_pos];
+    }
+    if(frame.gen_off != NULL){
+      c_off = frame.gen_off[x_pos];
+    }
+  }
+}
+
+static inline uint8_t led_low_bits(const lixie_frame &frame, uint16_t i){
+  if(frame.dither){
+    return dither_steps[(frame.count + i) & 7]; // Neighbours out of phase
+  }
+  return 128; // Round to nearest
+}
+
+// Reference kernel, one channel at a time
+void lixie_composite_scalar(lixie_frame &frame, uint16_t digit_index){
+  digit_masks dm = masks_for_digit(frame, digit_index);
+  uint16_t last_m = 0xFFFF;
+  uint16_t w_on = 0;
+  uint16_t w_off = 0;
+
+  uint16_t i = digit_index*frame.leds_per_digit;
+  uint16_t x_base = frame.max_x_pos - (digit_index*frame.x_width);
+  lixie_rgb *leds = frame.leds;
+
+  for(uint8_t pcb_index = 0; pcb_index < frame.leds_per_digit; pcb_index++, i++){
+    lixie_rgb c_on, c_off;
+    led_weights(frame, dm, i, last_m, w_on, w_off);
+    led_colors(frame, i, x_base, pcb_index, c_on, c_off);
+    uint8_t low_bits = led_low_bits(frame, i);
+
+    // w_on + w_off <= 256, so none of these can overflow 16 bits
+    leds[i].r = ((uint16_t)c_on.r*w_on + (uint16_t)c_off.r*w_off + low_bits) >> 8;
+    leds[i].g = ((uint16_t)c_on.g*w_on + (uint16_t)c_off.g*w_off + low_bits) >> 8;
+    leds[i].b = ((uint16_t)c_on.b*w_on + (uint16_t)c_off.b*w_off + low_bits) >> 8;
+  }
+}
+
+// One LED's channels in 16-bit lanes of a 64-bit word, red in the lowest
+static inline uint64_t rgb_lanes(lixie_rgb c){
+  return c.r | ((uint64_t)c.g << 16) | ((uint64_t)c.b << 32);
+}
+
+// Stands in for dither_steps when dithering is off, so lixie_composite_swar()
+// can look its low bits up either way
+static const uint8_t round_steps[8] = { 128, 128, 128, 128, 128, 128, 128, 128 };
+
+// The body of lixie_composite_swar(), built for each mix of generator or
+// none and full brightness or not - at full brightness the weights are the
+// mask itself. Nothing in the loop branches: with lit LEDs scattered over
+// a wall, a mispredicted branch costs more than the multiplies it skips.
+template<bool generating, bool full_level>
+static void composite_swar_leds(lixie_frame &frame, const digit_masks &dm, uint16_t digit_index){
+  const uint8_t *low_steps = frame.dither ? dither_steps : round_steps;
+  uint32_t fade = dm.fade;
+  uint32_t level = frame.level;
+
+  uint16_t i = digit_index*frame.leds_per_digit;
+  uint16_t x_base = frame.max_x_pos - (digit_index*frame.x_width);
+  lixie_rgb *leds = frame.leds;
+
+  for(uint8_t pcb_index = 0; pcb_index < frame.leds_per_digit; pcb_index++, i++){
+    uint32_t m = ((uint32_t)dm.from[i]*(256-fade) + (uint32_t)dm.to[i]*fade) >> 8;
+    m += m >> 7; // 0-255 -> 0-256
+    uint32_t w_on = m;
+    uint32_t w_off = 256 - m;
+    if(!full_level){
+      w_on  = (w_on * level) >> 8;
+      w_off = (w_off * level) >> 8;
+    }
+
+    lixie_rgb c_on, c_off;
+    if(generating){
+      led_colors(frame, i, x_base, pcb_index, c_on, c_off);
+    }
+    else{
+      c_on = frame.col_on[i];
+      c_off = frame.col_off[i];
+    }
+
+    uint64_t low_bits = low_steps[(frame.count + i) & 7] * 0x0000000100010001ULL;
+    uint64_t rgb = rgb_lanes(c_on)*w_on + rgb_lanes(c_off)*w_off + low_bits;
+    leds[i].r = rgb >> 8;
+    leds[i].g = rgb >> 24;
+    leds[i].b = rgb >> 40;
+  }
+}
+
+// Same math as lixie_composite_scalar(), but all three channels of an LED
+// are blended at once, two multiplies instead of six. No lane can carry
+// into the next since none exceeds 65280 + 255.
+void lixie_composite_swar(lixie_frame &frame, uint16_t digit_index){
+  digit_masks dm = masks_for_digit(frame, digit_index);
+  bool generating = (frame.gen_on != NULL || frame.gen_off != NULL);
+  if(generating){
+    if(frame.level == 256){
+      composite_swar_leds<true, true>(frame, dm, digit_index);
+    }
+    else{
+      composite_swar_leds<true, false>(frame, dm, digit_index);
+    }
+  }
+  else{
+    if(frame.level == 256){
+      composite_swar_leds<false, true>(frame, dm, digit_index);
+    }
+    else{
+      composite_swar_leds<false, false>(frame, dm, digit_index);
+    }
+  }
+}
+
+// Special panes override whatever was composited under them
+static void composite_special_panes(lixie_frame &frame, uint16_t digit_index){
+  if(frame.special_panes_enabled[digit_index]){
+    uint16_t start_index = digit_index*frame.leds_per_digit;
+    if(frame.special_leds[0] != 255){
+      frame.leds[start_index+frame.special_leds[0]] = frame.special_panes_color[digit_index*2];
+    }
+    if(frame.special_leds[1] != 255){
+      frame.leds[start_index+frame.special_leds[1]] = frame.special_panes_color[digit_index*2+1];
+    }
+  }
+}
+
+// Displays never share LEDs, masks or dirty flags, so ranges that don't
+// overlap can be composited at the same time.
+bool lixie_composite_digits(lixie_frame &frame, uint16_t first_digit, uint16_t end_digit){
+  bool any = false;
+  for(uint16_t digit_index = first_digit; digit_index < end_digit; digit_index++){
+    if(!frame.digit_dirty[digit_index]){
+      continue;
+    }
+    frame.digit_dirty[digit_index] = false; // Before drawing, so changes made meanwhile aren't lost
+    any = true;
+
+    if(frame.kernel == KERNEL_SCALAR){
+      lixie_composite_scalar(frame, digit_index);
+    }
+    else{
+      lixie_composite_swar(frame, digit_index);
+    }
+    composite_special_panes(frame, digit_index);
+  }
+  return any;
+}
+
+#if LIXIE_MAX_CORES > 1
+// Large walls are split into tiles of LIXIE_TILE_DIGITS displays. Each
+// core taking part claims the next tile until there are none left, so a
+// core that lands on clean tiles just claims more of them.
+bool lixie_composite_tiles(lixie_frame &frame){
+  bool any = false;
+  uint16_t n_tiles = (frame.n_digits + LIXIE_TILE_DIGITS - 1) / LIXIE_TILE_DIGITS;
+  for(;;){
+    uint16_t tile = __atomic_fetch_add(&frame.next_tile, 1, __ATOMIC_RELAXED);
+    if(tile >= n_tiles){
+      return any;
+    }
+    uint16_t first_digit = tile * LIXIE_TILE_DIGITS;
+    uint16_t end_digit = first_digit + LIXIE_TILE_DIGITS;
+    if(end_digit > frame.n_digits){
+      end_digit = frame.n_digits;
+    }
+    if(lixie_composite_digits(frame, first_digit, end_digit)){
+      any = true;
+    }
+  }
+}
+#endif
@@ -0,0 +1,99 @@
+/*
+	Lixie_Composite.h - Blends the ON and OFF layers of a wall of displays
+	into its LEDs
+
+	Used by Lixie_II, which fills in a lixie_frame before every frame. Like
+	Lixie_Protocol.h, nothing in here needs Arduino, so the kernels and the
+	tile scheduler can be checked and benchmarked on a host - see
+	extras/host.
+
+	Released under the GPLv3 License
+*/
+
+#ifndef lixie_composite_h
+#define lixie_composite_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#if defined(ARDUINO)
+	#include "Arduino.h" // Board config, PROGMEM
+#endif
+
+// Fields: independently written ranges of displays
+#define LIXIE_MAX_FIELDS	4
+#define LIXIE_NO_FIELD		255 // Not in a field, or add_field() failed
+
+// Compositing kernels, bit-exact with each other
+#define KERNEL_SCALAR		0
+#define KERNEL_SWAR			1 // Packed channels, see the "benchmark" example
+
+// Dual-core ESP32s can composite on both cores, see composite_cores(). A
+// host can call lixie_composite_tiles() from any number of threads, this
+// only has to be more than one there.
+#if !defined(ARDUINO)
+	#define LIXIE_MAX_CORES	64
+#elif defined(ARDUINO_ARCH_ESP32) && !defined(CONFIG_FREERTOS_UNICORE)
+	#define LIXIE_MAX_CORES	2
+#else
+	#define LIXIE_MAX_CORES	1
+#endif
+
+// Displays per tile when more than one core composites a frame
+#define LIXIE_TILE_DIGITS	4
+
+// Same layout as FastLED's CRGB, which Lixie_II casts to this
+struct lixie_rgb{
+	uint8_t r;
+	uint8_t g;
+	uint8_t b;
+};
+
+// Everything the kernels read. The wall and its buffers are set once,
+// the rest before every frame.
+struct lixie_frame{
+	uint16_t n_digits;
+	uint8_t  leds_per_digit;
+	uint8_t  x_width;
+	uint16_t max_x_pos;
+	const uint8_t *x_offsets;	// PROGMEM, from the layout
+	uint8_t  special_leds[2];	// 255 if the layout has no special pane
+
+	lixie_rgb *leds;					// Composited output
+	const lixie_rgb *col_on;			// Per LED
+	const lixie_rgb *col_off;
+	const uint8_t *mask_0;				// Per LED, 0-255
+	const uint8_t *mask_1;
+	const bool *special_panes_enabled;	// Per display
+	const lixie_rgb *special_panes_color;	// Two per display
+	const uint8_t *digit_field;			// Per display, or LIXIE_NO_FIELD
+	uint8_t *digit_dirty;				// Per display, cleared once composited
+
+	uint8_t  kernel;
+	uint8_t  current_mask;
+	uint8_t  field_mask[LIXIE_MAX_FIELDS];
+	uint16_t fade;  // 0-256
+	uint16_t field_fade[LIXIE_MAX_FIELDS];
+	uint16_t level; // 0-256
+	const lixie_rgb *gen_on;	// Generator caches by X-position, NULL if not generating
+	const lixie_rgb *gen_off;
+	bool     dither;
+	uint8_t  count;
+
+	volatile uint16_t next_tile; // Zero it before calling lixie_composite_tiles()
+};
+
+// One display, without its special panes
+void lixie_composite_scalar(lixie_frame &frame, uint16_t digit_index);
+void lixie_composite_swar(lixie_frame &frame, uint16_t digit_index);
+
+// Every dirty display in the range, returns true if there were any
+bool lixie_composite_digits(lixie_frame &frame, uint16_t first_digit, uint16_t end_digit);
+
+#if LIXIE_MAX_CORES > 1
+// Claims tiles until there are none left, returns true if any display was
+// composited. Every core or thread taking part in a frame calls this once.
+bool lixie_composite_tiles(lixie_frame &frame);
+#endif
+
+#endif
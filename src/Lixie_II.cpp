@@ -13,15 +13,29 @@ uint8_t get_size(uint32_t input);
 #define LED_TYPE WS2812B
 #define COLOR_ORDER GRB
 
-const uint8_t leds_per_digit = 22;
-uint8_t n_digits;      // Keeps the number of displays
+uint8_t leds_per_digit;  // From the layout
+uint8_t x_width;         // X-positions per display, from the layout
+const uint8_t frame_ms = 20; // 50 FPS animation ISR
+uint16_t n_digits;     // Keeps the number of displays
 uint16_t n_LEDs;       // Keeps the number of LEDs based on display quantity.
 CLEDController *lix_controller; // FastLED 
+Lixie_Output *lix_output = NULL; // Replaces lix_controller when set
 CRGB *lix_leds;
 
-const uint8_t led_assignments[leds_per_digit] = { 1, 9, 4, 6, 255, 7, 3, 0, 2, 8, 5, 5, 8, 2, 0, 3, 7, 255, 6, 4, 9, 1  }; // 255 is extra pane
-const uint8_t x_offsets[leds_per_digit]     = { 0, 0, 0, 0, 1,   1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 4,   5, 5, 5, 5  };
-uint8_t max_x_pos = 0;
+static constexpr uint8_t lixie_II_panes[22] = { 1, 9, 4, 6, 255, 7, 3, 0, 2, 8, 5, 5, 8, 2, 0, 3, 7, 255, 6, 4, 9, 1  }; // 255 is extra pane
+const uint8_t lixie_II_x_offsets[22] PROGMEM = { 0, 0, 0, 0, 1,   1, 1, 1, 2, 2, 2, 3, 3, 3, 4, 4, 4, 4,   5, 5, 5, 5  };
+LIXIE_LAYOUT(LIXIE_II_LAYOUT, lixie_II_panes, lixie_II_x_offsets, 6);
+
+// Lixie 1: each numeral lit by one LED on each half of the board, no special pane
+static constexpr uint8_t lixie_1_panes[20] = { 3, 9, 2, 0, 1, 6, 5, 7, 4, 8, 3, 9, 2, 0, 1, 6, 5, 7, 4, 8 };
+const uint8_t lixie_1_x_offsets[20] PROGMEM = { 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1 };
+LIXIE_LAYOUT(LIXIE_1_LAYOUT, lixie_1_panes, lixie_1_x_offsets, 2);
+
+// Active layout tables, still in flash
+const uint8_t *x_offsets;
+const uint32_t *pane_bits;
+uint8_t special_leds[2];
+uint16_t max_x_pos = 0;
 
 CRGB *col_on;
 CRGB *col_off;
@@ -29,13 +43,70 @@ CRGB *col_off;
 uint8_t *led_mask_0;
 uint8_t *led_mask_1;
 
+// Procedural color source for a layer, indexed by ON/OFF. Instead of storing
+// a color per LED, one color per X-position is cached and only refreshed when
+// the hue moves to a new step.
+struct lixie_generator{
+  uint8_t  type;
+  uint16_t hue;      // 8.8 fixed point
+  int16_t  hue_step; // 8.8 fixed point, added every frame
+  uint8_t  hue_sep;
+  uint8_t  cached_hue;
+  bool     cache_valid;
+  CRGB    *cache;
+};
+lixie_generator generators[2];
+
 bool *special_panes_enabled;
 CRGB *special_panes_color;
 
 uint8_t current_mask = 0;
 float mask_fader = 0.0;
 float mask_push = 1.0;
-bool mask_fade_finished = false;
+volatile bool mask_fade_finished = false;
+
+// Independently written ranges of displays, each with its own pair of
+// masks in use and its own fade. digit_field maps each display to the
+// field that owns it, or NO_FIELD.
+#define NO_FIELD LIXIE_NO_FIELD
+struct lixie_field{
+  bool used;
+  uint16_t first_digit;
+  uint16_t width;
+  uint8_t align;
+  bool zero_pad;
+  uint8_t trans_type;
+  uint16_t trans_time;
+  uint8_t current_mask;
+  float fader;
+  float push;
+};
+lixie_field fields[LIXIE_MAX_FIELDS];
+uint8_t *digit_field;
+
+// Displays only get composited again once something about them changes
+uint8_t *digit_dirty;
+volatile bool all_dirty = true;
+
+void mark_dirty(uint16_t first_digit, uint16_t count){
+  for(uint16_t d = first_digit; d < first_digit + count && d < n_digits; d++){
+    digit_dirty[d] = true;
+  }
+}
+
+void mark_all_dirty(){
+  all_dirty = true;
+}
+
+// Set by on_event(), called from the animation ISR - keep it short!
+void (*event_callback)(uint8_t event) = NULL;
+volatile bool animation_running = false;
+
+void fire_event(uint8_t event){
+  if(event_callback != NULL){
+    event_callback(event);
+  }
+}
 
 uint8_t trans_type = CROSSFADE;
 uint16_t trans_time = 250;
@@ -43,81 +114,352 @@ bool transition_mid_point = true;
 
 float bright = 1.0;
 
+// Temporal dithering, see Lixie_Composite.cpp
+bool dither_enabled = false;
+
 bool background_updates = true;
 
+// The ISR advances these by frame_ms every frame. source_slew holds
+// milliseconds still to be gained (+) or lost (-) to match sync_source(),
+// applied one per frame so the display never visibly jumps.
+uint8_t source_type = SOURCE_NONE;
+uint32_t source_count = 0;
+uint16_t source_period = 1000;
+uint16_t source_ms = 0;
+int32_t source_slew = 0;
+bool source_hour_12 = false;
+bool source_refresh = false;
+uint8_t *source_digits; // What each display currently shows
+
+bool state_restored = false; // restore_state() succeeded before begin()
+
+uint8_t rx_buffer[LIXIE_MAX_PACKET]; // read_commands() packet assembly
+uint16_t rx_len = 0;
+uint8_t *staged_buffer = NULL; // Only allocated once a packet arrives
+Lixie_Staged_Digits staged_write; // Writes wait here for a COMMIT
+
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
   Ticker lixie_animation;
 #endif
 
+#if LIXIE_MAX_CORES > 1
+  #include "freertos/semphr.h"
+#endif
+
+void show_frame(){
+  if(lix_output != NULL){
+    lix_output->show(lix_leds, n_LEDs);
+  }
+  else if(lix_controller != NULL){
+    lix_controller->showLeds();
+  }
+}
+
 uint16_t led_to_x_pos(uint16_t led){
-  uint8_t led_digit_pos = x_offsets[led%22];
+  uint8_t led_digit_pos = pgm_read_byte(&x_offsets[led%leds_per_digit]);
+  uint16_t complete_digits = led / leds_per_digit;
   
-  uint8_t complete_digits = 0;
-  while(led >= leds_per_digit){
-    led -= leds_per_digit;
-    complete_digits += 1;
+  return max_x_pos - (led_digit_pos + (complete_digits*x_width));
+}
+
+bool update_generator(lixie_generator &gen){
+  gen.hue += gen.hue_step;
+  uint8_t hue = gen.hue >> 8;
+  if(gen.cache_valid && hue == gen.cached_hue){
+    return false; // Nothing moved since the last frame
+  }
+  
+  for(uint16_t x = 0; x <= max_x_pos; x++){
+    uint8_t col_hue = hue;
+    if(gen.type == GENERATOR_GRADIENT){
+      col_hue += (gen.hue_sep * x) / max_x_pos;
+    }
+    else if(gen.type == GENERATOR_RAINBOW){
+      col_hue += gen.hue_sep * ((max_x_pos - x) / x_width);
+    }
+    gen.cache[x] = CHSV(col_hue, 255, 255);
   }
   
-  return max_x_pos - (led_digit_pos + (complete_digits*6));
+  gen.cached_hue = hue;
+  gen.cache_valid = true;
+  return true;
+}
+
+void restart_fade(){
+  mask_fader = 0.0;
+  
+  if(trans_type == INSTANT){
+    mask_push = 1.0;
+  }
+  else{
+    float trans_multiplier = trans_time / float(1000);
+    mask_push = 1 / (50.0 * trans_multiplier);
+  }
+  mask_fade_finished = false;
+  transition_mid_point = false;
+  mark_all_dirty();
+}
+
+// Lights the LEDs for number (0-9, 128 = blank, 255 = special pane) in one display of a mask
+void set_digit_mask(uint8_t *mask, uint16_t digit, uint8_t number){
+  uint32_t bits = 0;
+  if(number < 10){
+    bits = pgm_read_dword(&pane_bits[number]);
+  }
+  else if(number == LIXIE_SPECIAL_PANE){
+    bits = pgm_read_dword(&pane_bits[10]);
+  }
+  
+  uint8_t *digit_mask = mask + (leds_per_digit*digit);
+  for(uint8_t i = 0; i < leds_per_digit; i++){
+    digit_mask[i] = (bits & 1) ? 255 : 0;
+    bits >>= 1;
+  }
+  mark_dirty(digit, 1);
+}
+
+void show_source(){
+  uint32_t value = source_count;
+  uint8_t pad_digits = 0; // Displays from the right that show leading zeros
+  
+  if(source_type == SOURCE_CLOCK){
+    uint8_t hh = value / 3600;
+    uint8_t mm = (value / 60) % 60;
+    uint8_t ss = value % 60;
+    
+    if(source_hour_12){
+      if(hh > 12){
+        hh -= 12;
+      }
+      if(hh == 0){
+        hh = 12;
+      }
+    }
+    
+    value = (hh * 10000UL) + (mm * 100) + ss;
+    pad_digits = 6;
+    if(n_digits < 6){
+      value /= 100; // No room for seconds
+      pad_digits = 4;
+    }
+  }
+  
+  // Writes go to the mask being faded away from, then the two swap
+  uint8_t *mask_back  = (current_mask == 0) ? led_mask_0 : led_mask_1;
+  uint8_t *mask_front = (current_mask == 0) ? led_mask_1 : led_mask_0;
+  bool changed = false;
+  
+  uint16_t place = 0;
+  for(uint16_t d = 0; d < n_digits; d++){ // Display 0 is the rightmost
+    if(digit_field[d] != NO_FIELD){
+      continue; // Belongs to a field, the value flows around it
+    }
+    
+    uint8_t number = value % 10;
+    if(place > 0 && value == 0 && place >= pad_digits){
+      number = 128; // Blank leading zeros, past HHMMSS on a clock
+    }
+    value /= 10;
+    place++;
+    
+    if(number != source_digits[d]){
+      source_digits[d] = number;
+      set_digit_mask(mask_back, d, number);
+      changed = true;
+    }
+    else{
+      memcpy(mask_back + (d*leds_per_digit), mask_front + (d*leds_per_digit), leds_per_digit);
+    }
+  }
+  
+  if(changed){
+    current_mask = !current_mask;
+    restart_fade();
+  }
+}
+
+void update_source(){
+  uint8_t step = frame_ms;
+  if(source_slew > 0){
+    step++;
+    source_slew--;
+  }
+  else if(source_slew < 0){
+    step--;
+    source_slew++;
+  }
+  
+  bool countdown_done = false;
+  source_ms += step;
+  // Periods shorter than a frame count more than once per frame. step is
+  // at most frame_ms + 1 and source_period at least 1, so this is bounded.
+  while(source_ms >= source_period){
+    source_ms -= source_period;
+    
+    if(source_type == SOURCE_CLOCK){
+      source_count++;
+      if(source_count >= 86400){
+        source_count = 0;
+      }
+    }
+    else if(source_type == SOURCE_COUNTDOWN){
+      if(source_count > 0){
+        source_count--;
+        countdown_done = (source_count == 0);
+      }
+    }
+    else if(source_type == SOURCE_COUNTER){
+      source_count++;
+    }
+    source_refresh = true;
+  }
+  
+  if(source_refresh){
+    source_refresh = false;
+    show_source();
+  }
+  
+  if(countdown_done){
+    fire_event(EVENT_COUNTDOWN_END); // Zero is already up by now
+  }
+}
+
+// Compositing inputs, see Lixie_Composite.h. The kernels see every CRGB
+// buffer as lixie_rgb, which only works while the two match.
+lixie_frame frame;
+static_assert(sizeof(CRGB) == sizeof(lixie_rgb), "CRGB is no longer 3 bytes");
+
+uint8_t composite_kernel_type = KERNEL_SCALAR; // KERNEL_SWAR only where the "benchmark" example shows it's faster
+
+#if LIXIE_MAX_CORES > 1
+uint8_t n_cores = 1;
+
+// One worker per core, each asleep until a frame on the other core wakes
+// it. animate() runs on core 0 from the Ticker, or wherever run() is
+// called from, so whichever core that is, the other one can help.
+struct lixie_tile_worker{
+  TaskHandle_t task;
+  SemaphoreHandle_t start;
+  SemaphoreHandle_t done;
+  volatile bool any;
+};
+lixie_tile_worker tile_workers[LIXIE_MAX_CORES];
+
+void tile_worker_task(void *arg){
+  lixie_tile_worker &worker = *(lixie_tile_worker*)arg;
+  for(;;){
+    xSemaphoreTake(worker.start, portMAX_DELAY);
+    worker.any = lixie_composite_tiles(frame);
+    xSemaphoreGive(worker.done);
+  }
+}
+
+void start_tile_workers(){
+  for(uint8_t core = 0; core < LIXIE_MAX_CORES; core++){
+    lixie_tile_worker &worker = tile_workers[core];
+    if(worker.task == NULL){
+      worker.start = xSemaphoreCreateBinary();
+      worker.done = xSemaphoreCreateBinary();
+      // Same priority as the esp_timer task behind Ticker, under WiFi's
+      xTaskCreatePinnedToCore(tile_worker_task, "lixie_tiles", 2048, &worker, configMAX_PRIORITIES - 3, &worker.task, core);
+    }
+  }
+}
+#endif
+
+// Returns true if any display was composited
+bool composite_frame(){
+#if LIXIE_MAX_CORES > 1
+  if(n_cores > 1 && n_digits > LIXIE_TILE_DIGITS){
+    lixie_tile_worker &worker = tile_workers[1 - xPortGetCoreID()];
+    frame.next_tile = 0;
+    xSemaphoreGive(worker.start);
+    bool any = lixie_composite_tiles(frame);
+    xSemaphoreTake(worker.done, portMAX_DELAY); // Every tile is done before anything is sent
+    return any || worker.any;
+  }
+#endif
+  return lixie_composite_digits(frame, 0, n_digits);
 }
 
 void animate(){
+  if(source_type != SOURCE_NONE){
+    update_source();
+  }
+  
+  if(all_dirty){
+    all_dirty = false;
+    memset(digit_dirty, true, n_digits);
+  }
+  
+  if(generators[ON].type != GENERATOR_NONE){
+    if(update_generator(generators[ON])){
+      memset(digit_dirty, true, n_digits);
+    }
+  }
+  if(generators[OFF].type != GENERATOR_NONE){
+    if(update_generator(generators[OFF])){
+      memset(digit_dirty, true, n_digits);
+    }
+  }
+  if(dither_enabled){
+    memset(digit_dirty, true, n_digits); // Different every frame
+  }
+  
   if(mask_fader < 1.0){
     mask_fader += mask_push;
+    for(uint16_t d = 0; d < n_digits; d++){
+      if(digit_field[d] == NO_FIELD){
+        digit_dirty[d] = true;
+      }
+    }
   }
   
   if(mask_fader >= 1.0){
     mask_fader = 1.0;
     if(!mask_fade_finished){
       mask_fade_finished = true;
-      
+      fire_event(EVENT_TRANSITION_END); // Anything written in here starts fading this frame
     }
   }
   else if(mask_fader >= 0.5){
     transition_mid_point = true;
   }
   
-  uint8_t pcb_index = 0;
-  
-  for(uint16_t i = 0; i < n_LEDs; i++){
-    float mask_float;
-    CRGB new_col;
-    uint8_t mask_input_0 = led_mask_0[i];
-    uint8_t mask_input_1 = led_mask_1[i];
-
-    if(trans_type == INSTANT || trans_type == CROSSFADE){
-      if(current_mask == 0){  
-        mask_float = ((mask_input_0*(1-mask_fader)) + (mask_input_1*(mask_fader)))/255.0;
-      }
-      else if(current_mask == 1){
-        mask_float = ((mask_input_1*(1-mask_fader)) + (mask_input_0*(mask_fader)))/255.0;
+  for(uint8_t f = 0; f < LIXIE_MAX_FIELDS; f++){
+    lixie_field &field = fields[f];
+    if(field.used && field.fader < 1.0){
+      field.fader += field.push;
+      if(field.fader > 1.0){
+        field.fader = 1.0;
       }
+      mark_dirty(field.first_digit, field.width);
     }
-    
-    new_col.r = ((col_on[i].r*mask_float) + (col_off[i].r*(1-mask_float)))*bright;
-    new_col.g = ((col_on[i].g*mask_float) + (col_off[i].g*(1-mask_float)))*bright;
-    new_col.b = ((col_on[i].b*mask_float) + (col_off[i].b*(1-mask_float)))*bright;
-    
-    lix_leds[i] = new_col;  
-	
-	// Check for special pane enabled for the current digit, and use its color instead if it is.
-	uint8_t digit_index = i/leds_per_digit;
-	if(special_panes_enabled[digit_index]){
-		if(pcb_index == 4){
-			lix_leds[i] = special_panes_color[digit_index*2];
-		}
-		else if(pcb_index == 17){
-			lix_leds[i] = special_panes_color[digit_index*2+1];
-		}
-	}
-	
-    pcb_index++;
-	if(pcb_index >= leds_per_digit){
-		pcb_index = 0;
-	}
+    frame.field_mask[f] = field.current_mask;
+    frame.field_fade[f] = field.fader * 256;
+  }
+  
+  // Everything below is 8.8 fixed point. Each channel is composited to 16
+  // bits, and only the final shift drops to the 8 bits the LEDs take, with
+  // the low byte either rounded or temporally dithered. This has to stay
+  // well under 30us per LED (the time one WS2812B takes to receive its
+  // 24 bits) even on a 16MHz AVR - see the "benchmark" example.
+  frame.fade = mask_fader * 256;
+  frame.level = 256;
+  if(bright < 1.0){
+    frame.level = (bright > 0.0) ? uint16_t(bright * 256) : 0;
+  }
+  frame.gen_on  = (generators[ON].type  != GENERATOR_NONE) ? (const lixie_rgb*)generators[ON].cache  : NULL;
+  frame.gen_off = (generators[OFF].type != GENERATOR_NONE) ? (const lixie_rgb*)generators[OFF].cache : NULL;
+  frame.kernel = composite_kernel_type;
+  frame.current_mask = current_mask;
+  frame.dither = dither_enabled;
+  frame.count++;
+  
+  bool changed = composite_frame();
+  if(changed || (lix_output != NULL && lix_output->refresh_due())){ // Nothing changed, nothing to send
+    show_frame();
   }
-      
-  lix_controller->showLeds(); 
 }
 
 void Lixie_II::transition_type(uint8_t type){
@@ -133,14 +475,32 @@ void Lixie_II::run(){
 }
 
 void Lixie_II::wait(){
-  while(mask_fader < 1.0){
-    animate();
+  if(animation_running){
+    // The ISR is already rendering, so just stay out of its way
+    while(!mask_fade_finished){
+      delay(1); // Also yields to WiFi on ESP
+    }
+  }
+  else{
+    while(!mask_fade_finished){
+      animate();
+      delay(frame_ms);
+    }
   }
 }
 
+bool Lixie_II::transition_finished(){
+  return mask_fade_finished;
+}
+
+void Lixie_II::on_event(void (*callback)(uint8_t event)){
+  event_callback = callback;
+}
+
 void Lixie_II::start_animation(){
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
-  lixie_animation.attach_ms(20, animate);
+  lixie_animation.attach_ms(frame_ms, animate);
+  animation_running = true;
 #elif defined(__AVR__)  
   // TIMER 1 for interrupt frequency 50 Hz:
   cli(); // stop interrupts
@@ -156,7 +516,9 @@ void Lixie_II::start_animation(){
   // enable timer compare interrupt
   TIMSK1 |= (1 << OCIE1A);
   sei(); // allow interrupts
+  animation_running = true;
 #endif
+  mark_all_dirty();
 }
 
 #if defined(__AVR__)  
@@ -168,13 +530,29 @@ ISR(TIMER1_COMPA_vect){
 void Lixie_II::stop_animation(){
 #if defined(ARDUINO_ARCH_ESP8266) || defined(ARDUINO_ARCH_ESP32)
   lixie_animation.detach();
+#elif defined(__AVR__)
+  TIMSK1 &= ~(1 << OCIE1A); // disable timer compare interrupt
 #endif
+  animation_running = false;
 }
 
-Lixie_II::Lixie_II(const uint8_t pin, uint8_t number_of_digits){
+Lixie_II::Lixie_II(const uint8_t pin, uint16_t number_of_digits, const Lixie_Layout &layout){
+  leds_per_digit = layout.leds_per_digit;
+  x_width = layout.x_width;
+  x_offsets = layout.x_offsets;
+  pane_bits = layout.pane_bits;
+  special_leds[0] = layout.special_leds[0];
+  special_leds[1] = layout.special_leds[1];
+  
+  // n_LEDs is 16-bit, and kept a little under 65536 so loops stepping 8
+  // LEDs at a time can't wrap. That caps a wall at 2978 Lixie IIs.
+  if(number_of_digits > LIXIE_MAX_LEDS / layout.leds_per_digit){
+    number_of_digits = LIXIE_MAX_LEDS / layout.leds_per_digit;
+  }
+  
   n_LEDs = number_of_digits * leds_per_digit;
   n_digits = number_of_digits;
-  max_x_pos = (number_of_digits * 6)-1;
+  max_x_pos = (number_of_digits * x_width)-1;
   
   lix_leds = new CRGB[n_LEDs];  
   led_mask_0 = new uint8_t[n_LEDs];
@@ -194,10 +572,36 @@ Lixie_II::Lixie_II(const uint8_t pin, uint8_t number_of_digits){
     col_off[i] = CRGB(0,0,0);
   }
   
+  digit_field = new uint8_t[n_digits];
+  digit_dirty = new uint8_t[n_digits];
+  
+  for(uint16_t i = 0; i < n_digits; i++){
+	special_panes_enabled[i] = false;
+	digit_field[i] = NO_FIELD;
+	digit_dirty[i] = true;
+  }
+  
   for(uint16_t i = 0; i < n_digits*2; i++){
 	special_panes_color[i] = CRGB(255,255,255);
   }
-  
+
+  frame.n_digits = n_digits;
+  frame.leds_per_digit = leds_per_digit;
+  frame.x_width = x_width;
+  frame.max_x_pos = max_x_pos;
+  frame.x_offsets = x_offsets;
+  frame.special_leds[0] = special_leds[0];
+  frame.special_leds[1] = special_leds[1];
+  frame.leds = (lixie_rgb*)lix_leds;
+  frame.col_on = (const lixie_rgb*)col_on;
+  frame.col_off = (const lixie_rgb*)col_off;
+  frame.mask_0 = led_mask_0;
+  frame.mask_1 = led_mask_1;
+  frame.special_panes_enabled = special_panes_enabled;
+  frame.special_panes_color = (const lixie_rgb*)special_panes_color;
+  frame.digit_field = digit_field;
+  frame.digit_dirty = digit_dirty;
+
   build_controller(pin);
 }
 
@@ -219,43 +623,52 @@ void Lixie_II::build_controller(const uint8_t pin){
     //FastLED.addLeds<LED_TYPE, 13, COLOR_ORDER>(lix_leds, n_LEDs);
 }
 
+void Lixie_II::output(Lixie_Output *out){
+  lix_output = out; // NULL goes back to the local controller
+  mark_all_dirty();
+}
+
 void Lixie_II::begin(){
   max_power(5,500); // Default for the safety of your PC USB
+  if(state_restored){
+    animate(); // Show the restored frame now, not a frame from now
+  }
   start_animation();
 }
 
 void Lixie_II::max_power(uint8_t V, uint16_t mA){
   FastLED.setMaxPowerInVoltsAndMilliamps(V, mA);
+  mark_all_dirty();
 }
 
+// write() and friends only draw displays outside of fields, which have
+// masks of their own
 void Lixie_II::clear_all(){
-  if(current_mask == 0){
-    for(uint16_t i = 0; i < n_LEDs; i++){
-      led_mask_0[i] = 0;
+  uint8_t *mask = (current_mask == 0) ? led_mask_0 : led_mask_1;
+  for(uint16_t d = 0; d < n_digits; d++){
+    if(digit_field[d] == NO_FIELD){
+      memset(mask + (d*leds_per_digit), 0, leds_per_digit);
     }
   }
-  else if(current_mask == 1){
-    for(uint16_t i = 0; i < n_LEDs; i++){
-      led_mask_1[i] = 0;
-    }
+}
+
+void Lixie_II::push_value(uint32_t input){
+  uint32_t n_place = 1;
+  // Powers of 10 while avoiding floating point math
+  for(uint8_t i = 1; i < get_size(input); i++){
+    n_place *= 10;
+  }
+
+  for(n_place; n_place > 0; n_place /= 10){
+    push_digit(input / n_place);
+    if(n_place > 1) input = (input % n_place);
   }
 }
 
 void Lixie_II::write(uint32_t input){
   //if(get_size(input) <= n_digits){
     clear_all();
-    
-    uint32_t n_place = 1;
-    // Powers of 10 while avoiding floating point math
-    for(uint8_t i = 1; i < get_size(input); i++){
-      n_place *= 10;
-    }
-
-    for(n_place; n_place > 0; n_place /= 10){
-      push_digit(input / n_place);
-      if(n_place > 1) input = (input % n_place);
-    }
-      
+    push_value(input);
   //}
   
   if(current_mask == 0){
@@ -268,6 +681,120 @@ void Lixie_II::write(uint32_t input){
   mask_update();
 }
 
+// Fields are numbered from the right like displays: a field starting at
+// digit 0 with a width of 2 is the rightmost pair. Returns the new
+// field's id, or LIXIE_NO_FIELD if it doesn't fit or overlaps another.
+// write(), value sources and the like skip a field's displays from then
+// on, and numbers flow around it.
+uint8_t Lixie_II::add_field(uint16_t first_digit, uint16_t width, uint8_t align, bool zero_pad){
+  if(width == 0 || width > n_digits || first_digit > n_digits - width){
+    return NO_FIELD;
+  }
+  for(uint16_t d = first_digit; d < first_digit + width; d++){
+    if(digit_field[d] != NO_FIELD){
+      return NO_FIELD;
+    }
+  }
+  
+  for(uint8_t id = 0; id < LIXIE_MAX_FIELDS; id++){
+    lixie_field &field = fields[id];
+    if(!field.used){
+      field.first_digit = first_digit;
+      field.width = width;
+      field.align = align;
+      field.zero_pad = zero_pad;
+      field.trans_type = trans_type;
+      field.trans_time = trans_time;
+      field.fader = 1.0;
+      field.push = 1.0;
+      field.current_mask = current_mask; // Keeps showing what write() last put here
+      
+      field.used = true;
+      for(uint16_t d = first_digit; d < first_digit + width; d++){
+        digit_field[d] = id;
+      }
+      mark_dirty(first_digit, width);
+      return id;
+    }
+  }
+  return NO_FIELD;
+}
+
+// The displays go back to following write()
+void Lixie_II::remove_field(uint8_t id){
+  if(id >= LIXIE_MAX_FIELDS || !fields[id].used){
+    return;
+  }
+  lixie_field &field = fields[id];
+  for(uint16_t d = field.first_digit; d < field.first_digit + field.width; d++){
+    digit_field[d] = NO_FIELD;
+  }
+  field.used = false;
+  mark_dirty(field.first_digit, field.width);
+}
+
+// Only this field's displays are touched, and only they are composited
+// again until its transition ends. Values too long for the field keep
+// their lowest digits.
+void Lixie_II::write_field(uint8_t id, uint32_t value){
+  if(id >= LIXIE_MAX_FIELDS || !fields[id].used){
+    return;
+  }
+  lixie_field &field = fields[id];
+  uint8_t *mask = (field.current_mask == 0) ? led_mask_0 : led_mask_1;
+  
+  uint16_t len = get_size(value);
+  if(len > field.width || field.zero_pad){
+    len = field.width;
+  }
+  uint16_t shift = 0; // Blank displays on the right
+  if(field.align == ALIGN_LEFT){
+    shift = field.width - len;
+  }
+  
+  for(uint16_t i = 0; i < field.width; i++){
+    uint8_t number = 128;
+    if(i >= shift && i < shift + len){
+      number = value % 10;
+      value /= 10;
+    }
+    set_digit_mask(mask, field.first_digit + i, number);
+  }
+  
+  field.current_mask = !field.current_mask;
+  field.fader = 0.0;
+  if(field.trans_type == INSTANT){
+    field.push = 1.0;
+  }
+  else{
+    field.push = 1 / (50.0 * (field.trans_time / float(1000)));
+  }
+}
+
+void Lixie_II::field_transition(uint8_t id, uint8_t type, uint16_t ms){
+  if(id >= LIXIE_MAX_FIELDS){
+    return;
+  }
+  fields[id].trans_type = type;
+  fields[id].trans_time = ms;
+}
+
+void Lixie_II::field_color(uint8_t id, uint8_t layer, CRGB col){
+  if(id >= LIXIE_MAX_FIELDS || !fields[id].used){
+    return;
+  }
+  for(uint16_t d = fields[id].first_digit; d < fields[id].first_digit + fields[id].width; d++){
+    color_display(d, layer, col);
+  }
+}
+
+bool Lixie_II::field_finished(uint8_t id){
+  if(id >= LIXIE_MAX_FIELDS){
+    return true;
+  }
+  return fields[id].fader >= 1.0;
+}
+
 bool char_is_number(char input){
   if(input <= 57 && input >= 48) // if equal to or between ASCII '0' and '9'
     return true;
@@ -346,84 +873,48 @@ void Lixie_II::write_float(float input_raw, uint8_t dec_places){
 void Lixie_II::push_digit(uint8_t number) {
   // 0-9 are rendered normally when passed in, but 128 = blank display & 255 = special pane
 	
-  // If multiple displays, move all LED states forward one
-  if (n_digits > 1) {
-    for (uint16_t i = n_LEDs - 1; i >= leds_per_digit; i--) {
-      if(current_mask == 0){
-        led_mask_0[i] = led_mask_0[i - leds_per_digit];
-      }
-      else{
-        led_mask_1[i] = led_mask_1[i - leds_per_digit];
-      }
-    }
-  }
+  uint8_t *mask = (current_mask == 0) ? led_mask_0 : led_mask_1;
   
-  // Clear the LED states for the first display
-  for (uint16_t i = 0; i < leds_per_digit; i++) {
-    if(current_mask == 0){
-      led_mask_0[i] = led_mask_0[i - leds_per_digit];
-    }
-    else{
-      led_mask_1[i] = led_mask_1[i - leds_per_digit];
-    }
+  // Move every display's LEDs forward one, stepping over displays in a
+  // field so numbers flow around them
+  int32_t to = n_digits - 1;
+  while(to >= 0 && digit_field[to] != NO_FIELD){
+    to--;
   }
-  
-  if(number != 128){
-	  for(uint8_t i = 0; i < leds_per_digit; i++){
-		if(led_assignments[i] == number){
-		  if(current_mask == 0){
-			led_mask_0[i] = 255;
-		  }
-		  else{
-			led_mask_1[i] = 255;
-		  }
-		}
-		else{
-		  if(current_mask == 0){
-			led_mask_0[i] = 0;
-		  }
-		  else{
-			led_mask_1[i] = 0;
-		  }
-		}
-	  }
+  if(to < 0){
+    return; // Every display belongs to a field
   }
-  else{
-	  for(uint8_t i = 0; i < leds_per_digit; i++){
-		  if(current_mask == 0){
-			led_mask_0[i] = 0;
-		  }
-		  else{
-			led_mask_1[i] = 0;
-		  }
-	  }
+  for(int32_t from = to - 1; from >= 0; from--){
+    if(digit_field[from] != NO_FIELD){
+      continue;
+    }
+    memcpy(mask + (to*leds_per_digit), mask + (from*leds_per_digit), leds_per_digit);
+    to = from;
   }
+  
+  // Then draw the new number into the first display
+  set_digit_mask(mask, to, number);
 }
 
-void Lixie_II::write_digit(uint8_t digit, uint8_t num){
-  uint16_t start_index = leds_per_digit*digit;
-  
-  if(num < 10){
-    clear_digit(digit,num);
-    for(uint8_t i = 0; i < leds_per_digit; i++){      
-      if(led_assignments[i] == num){
-        
-        if(current_mask == 0){
-          led_mask_1[start_index+i] = 255;
-        }
-        else if(current_mask == 1){
-          led_mask_0[start_index+i] = 255;
-        }       
-      }
+void Lixie_II::write_digit(uint16_t digit, uint8_t num){
+  if(num < 10 && digit < n_digits && digit_field[digit] == NO_FIELD){
+    if(current_mask == 0){
+      set_digit_mask(led_mask_1, digit, num);
+    }
+    else if(current_mask == 1){
+      set_digit_mask(led_mask_0, digit, num);
     }
     
     mask_update();
   }
 }
 
-void Lixie_II::clear_digit(uint8_t digit, uint8_t num){
+void Lixie_II::clear_digit(uint16_t digit, uint8_t num){
+  if(digit >= n_digits || digit_field[digit] != NO_FIELD){
+    return;
+  }
   uint16_t start_index = leds_per_digit*digit;
-  for(uint8_t i = 0; i < 22; i++){
+  for(uint8_t i = 0; i < leds_per_digit; i++){
     if(current_mask == 0){
       led_mask_1[start_index+i] = 0;//CRGB(0*0.06,100*0.06,255*0.06);   
     }
@@ -435,11 +926,10 @@ void Lixie_II::clear_digit(uint8_t digit, uint8_t num){
   mask_update();
 }
 
-void Lixie_II::special_pane(uint8_t index, bool enabled, CRGB col1, CRGB col2){
+void Lixie_II::special_pane(uint16_t index, bool enabled, CRGB col1, CRGB col2){
 	special_panes_enabled[index] = enabled;
 	if(enabled){
 		if(col2.r != 0 || col2.g != 0 || col2.b != 0){ // use second color if defined
-			Serial.println("\n\n\nSPECIAL COL 2");
 			special_panes_color[(index*2)+1] = col1;
 			special_panes_color[index*2]     = col2;
 		}
@@ -452,25 +942,17 @@ void Lixie_II::special_pane(uint8_t index, bool enabled, CRGB col1, CRGB col2){
 		special_panes_color[index*2+1] = CRGB(0,0,0);
 		special_panes_color[index*2]   = CRGB(0,0,0);
 	}
+	mark_dirty(index, 1);
 }
 
 void Lixie_II::mask_update(){
-  mask_fader = 0.0;
-  
-  if(trans_type == INSTANT){
-    mask_push = 1.0;
-  }
-  else{
-    float trans_multiplier = trans_time / float(1000);
-    mask_push = 1 / (50.0 * trans_multiplier);
-  }
-  mask_fade_finished = false;
-  transition_mid_point = false;
+  restart_fade();
   
   // WAIT GOES HERE
 }
 
 void Lixie_II::color_all(uint8_t layer, CRGB col){
+  generators[layer & 1].type = GENERATOR_NONE;
   for(uint16_t i = 0; i < n_LEDs; i++){
     if(layer == ON){
       col_on[i] = col;
@@ -479,9 +961,11 @@ void Lixie_II::color_all(uint8_t layer, CRGB col){
       col_off[i] = col;
     }
   }
+  mark_all_dirty();
 }
 
 void Lixie_II::color_all_dual(uint8_t layer, CRGB col_left, CRGB col_right){
+  generators[layer & 1].type = GENERATOR_NONE;
   bool side = 1;
   for(uint16_t i = 0; i < n_LEDs; i++){
     if(i % (leds_per_digit/2) == 0){
@@ -505,9 +989,14 @@ void Lixie_II::color_all_dual(uint8_t layer, CRGB col_left, CRGB col_right){
       }
     }
   }
+  mark_all_dirty();
 }
 
-void Lixie_II::color_display(uint8_t display, uint8_t layer, CRGB col){
+void Lixie_II::color_display(uint16_t display, uint8_t layer, CRGB col){
+  if(generators[layer & 1].type != GENERATOR_NONE){
+    generators[layer & 1].type = GENERATOR_NONE;
+    mark_all_dirty(); // The whole layer changes, not just this display
+  }
   uint16_t start_index = leds_per_digit*display;
   for(uint16_t i = 0; i < leds_per_digit; i++){
     if(layer == ON){
@@ -517,9 +1006,11 @@ void Lixie_II::color_display(uint8_t display, uint8_t layer, CRGB col){
       col_off[start_index+i] = col;
     }
   }
+  mark_dirty(display, 1);
 }
 
 void Lixie_II::gradient_rgb(uint8_t layer, CRGB col_left, CRGB col_right){
+  generators[layer & 1].type = GENERATOR_NONE;
   for(uint16_t i = 0; i < n_LEDs; i++){
     float progress = 1-(led_to_x_pos(i)/float(max_x_pos));
 
@@ -535,22 +1026,71 @@ void Lixie_II::gradient_rgb(uint8_t layer, CRGB col_left, CRGB col_right){
       col_off[i] = col_out;
     }
   }
+  mark_all_dirty();
+}
+
+void Lixie_II::color_generator(uint8_t layer, uint8_t type, uint8_t hue, uint8_t hue_sep, float rate){
+  lixie_generator &gen = generators[layer & 1];
+  
+  if(gen.cache == NULL){
+    gen.cache = new CRGB[max_x_pos+1]; // Only allocated once a generator is used
+  }
+  
+  gen.type = GENERATOR_NONE; // Keep the ISR away until the new settings are in
+  gen.hue = hue << 8;
+  gen.hue_step = rate * (256 / 50.0); // Hue steps per second -> 8.8 steps per frame
+  gen.hue_sep = hue_sep;
+  gen.cache_valid = false; // Rebuilt by the ISR before its next frame
+  gen.type = type;
+  mark_all_dirty();
 }
 
 void Lixie_II::brightness(float level){
   //FastLED.setBrightness(255*level); // NOT SUPPORTED WITH CLEDCONTROLLER :(
   bright = level; // We instead enforce brightness in the animation ISR
+  mark_all_dirty();
 }
 
 void Lixie_II::brightness(double level){
   //FastLED.setBrightness(255*level); // NOT SUPPORTED WITH CLEDCONTROLLER :(
   bright = level; // We instead enforce brightness in the animation ISR
+  mark_all_dirty();
+}
+
+void Lixie_II::composite_kernel(uint8_t kernel){
+  composite_kernel_type = kernel;
+  mark_all_dirty();
+}
+
+// Cores to composite with, returns how many will actually be used. Only
+// dual-core ESP32s have a second one, and it only pays off on walls big
+// enough that handing it half the work beats waking it up - see the
+// "WALL_BENCHMARK" example.
+uint8_t Lixie_II::composite_cores(uint8_t cores){
+  if(cores < 1){
+    cores = 1;
+  }
+  if(cores > LIXIE_MAX_CORES){
+    cores = LIXIE_MAX_CORES;
+  }
+#if LIXIE_MAX_CORES > 1
+  if(cores > 1){
+    start_tile_workers();
+  }
+  n_cores = cores;
+#endif
+  return cores;
+}
+
+void Lixie_II::dithering(bool enabled){
+  dither_enabled = enabled;
+  mark_all_dirty();
 }
 
 void Lixie_II::fade_in(){
   for(int16_t i = 0; i < 255; i++){
     brightness(i/255.0);
-    FastLED.delay(1);
+    delay(1); // animate() redraws and shows each level
   }
   brightness(1.0);
 }
@@ -558,13 +1098,13 @@ void Lixie_II::fade_in(){
 void Lixie_II::fade_out(){
   for(int16_t i = 255; i > 0; i--){
     brightness(i/255.0);
-    FastLED.delay(1);
+    delay(1); // animate() redraws and shows each level
   }
   brightness(0.0);
 }
 
 void Lixie_II::streak(CRGB col, float pos, uint8_t blur){
-  float pos_whole = pos*n_digits*6; // 6 X-positions in a single display
+  float pos_whole = pos*n_digits*x_width; // x_width X-positions in a single display
   
   for(uint16_t i = 0; i < n_LEDs; i++){
     uint16_t pos_delta = abs(led_to_x_pos(i) - pos_whole);
@@ -577,7 +1117,8 @@ void Lixie_II::streak(CRGB col, float pos, uint8_t blur){
     
     lix_leds[i] = CRGB(col.r * pos_level, col.g * pos_level, col.b * pos_level);
   }
-  lix_controller->showLeds();
+  show_frame();
+  mark_all_dirty(); // Drawn over every display, so the next frame redraws them all
 }
 
 void Lixie_II::sweep_color(CRGB col, uint16_t speed, uint8_t blur, bool reverse){
@@ -589,16 +1130,19 @@ void Lixie_II::sweep_color(CRGB col, uint16_t speed, uint8_t blur, bool reverse)
 void Lixie_II::sweep_gradient(CRGB col_left, CRGB col_right, uint16_t speed, uint8_t blur, bool reverse){
   stop_animation();
   
+  // Signed, as the streak starts and ends off the edges of the display
+  int32_t x_last = max_x_pos;
+  
   if(!reverse){
-    for(int16_t sweep_pos = (blur*-1); sweep_pos <= max_x_pos+(blur); sweep_pos++){
-      int16_t sweep_pos_fixed = sweep_pos;
+    for(int32_t sweep_pos = -blur; sweep_pos <= x_last+blur; sweep_pos++){
+      int32_t sweep_pos_fixed = sweep_pos;
       if(sweep_pos < 0){
         sweep_pos_fixed = 0;
       }
-      if(sweep_pos > max_x_pos){
-        sweep_pos_fixed = max_x_pos;
+      if(sweep_pos > x_last){
+        sweep_pos_fixed = x_last;
       }
-      float progress = 1-(sweep_pos_fixed/float(max_x_pos));
+      float progress = 1-(sweep_pos_fixed/float(x_last));
 
       CRGB col_out = CRGB(0,0,0);
       col_out.r = (col_right.r*(1-progress)) + (col_left.r*(progress));
@@ -606,19 +1150,19 @@ void Lixie_II::sweep_gradient(CRGB col_left, CRGB col_right, uint16_t speed, uin
       col_out.b = (col_right.b*(1-progress)) + (col_left.b*(progress));
       
       streak(col_out, 1-progress, blur);
-      FastLED.delay(speed);
+      delay(speed); // streak() already showed this step
     }
   }
   else{
-    for(int16_t sweep_pos = max_x_pos+(blur); sweep_pos >= (blur*-1); sweep_pos--){
-      int16_t sweep_pos_fixed = sweep_pos;
+    for(int32_t sweep_pos = x_last+blur; sweep_pos >= -blur; sweep_pos--){
+      int32_t sweep_pos_fixed = sweep_pos;
       if(sweep_pos < 0){
         sweep_pos_fixed = 0;
       }
-      if(sweep_pos > max_x_pos){
-        sweep_pos_fixed = max_x_pos;
+      if(sweep_pos > x_last){
+        sweep_pos_fixed = x_last;
       }
-      float progress = 1-(sweep_pos_fixed/float(max_x_pos));
+      float progress = 1-(sweep_pos_fixed/float(x_last));
 
       CRGB col_out = CRGB(0,0,0);
       col_out.r = (col_right.r*(1-progress)) + (col_left.r*(progress));
@@ -626,12 +1170,108 @@ void Lixie_II::sweep_gradient(CRGB col_left, CRGB col_right, uint16_t speed, uin
       col_out.b = (col_right.b*(1-progress)) + (col_left.b*(progress));
       
       streak(col_out, progress, blur);
-      FastLED.delay(speed);
+      delay(speed); // streak() already showed this step
     }
   }
   start_animation();
 }
 
+void start_source(uint8_t type, uint32_t start, uint16_t period_ms){
+  if(source_digits == NULL){
+    source_digits = new uint8_t[n_digits];
+  }
+  
+  noInterrupts();
+  for(uint16_t d = 0; d < n_digits; d++){
+    source_digits[d] = 0xFE; // Nothing shown yet, so every display counts as changed
+  }
+  source_type = type;
+  source_count = start;
+  source_period = (period_ms > 0) ? period_ms : 1;
+  source_ms = 0;
+  source_slew = 0;
+  source_refresh = true; // Shown on the very next frame
+  interrupts();
+}
+
+void Lixie_II::clock_source(uint32_t seconds, bool hour_12){
+  source_hour_12 = hour_12;
+  start_source(SOURCE_CLOCK, seconds % 86400, 1000);
+}
+
+void Lixie_II::countdown_source(uint32_t start, uint16_t period_ms){
+  start_source(SOURCE_COUNTDOWN, start, period_ms);
+}
+
+void Lixie_II::counter_source(uint32_t start, uint16_t period_ms){
+  start_source(SOURCE_COUNTER, start, period_ms);
+}
+
+void Lixie_II::stop_source(){
+  source_type = SOURCE_NONE;
+}
+
+// The reference is a whole number of periods, so on its own it could be
+// anywhere from just after value began to just before value+1. Only an
+// error bigger than that window is corrected, or reading it just across a
+// boundary would look like a period of drift. phase_ms, when the caller
+// has it (e.g. the milliseconds of an NTP time), narrows the window to a
+// frame either side.
+void Lixie_II::sync_source(uint32_t value, uint16_t phase_ms){
+  int32_t phase_lo = 0;
+  int32_t phase_hi = source_period;
+  if(phase_ms != LIXIE_PHASE_UNKNOWN){
+    phase_lo = int32_t(phase_ms) - frame_ms;
+    phase_hi = int32_t(phase_ms) + frame_ms;
+  }
+  
+  noInterrupts();
+  // How many periods the ISR's count is ahead of the reference
+  int32_t ahead = source_count - value;
+  if(source_type == SOURCE_COUNTDOWN){
+    ahead = -ahead;
+  }
+  else if(source_type == SOURCE_CLOCK){
+    if(ahead > 43200){ // Wrapped around midnight
+      ahead -= 86400;
+    }
+    else if(ahead < -43200){
+      ahead += 86400;
+    }
+  }
+  
+  // Milliseconds ahead (+) or behind (-) of the nearest edge of the window
+  int32_t error = 0;
+  bool near = (ahead >= -1 && ahead <= 1);
+  if(near){
+    int32_t ahead_ms = ahead * int32_t(source_period) + source_ms;
+    if(ahead_ms > phase_hi){
+      error = ahead_ms - phase_hi;
+    }
+    else if(ahead_ms < phase_lo){
+      error = ahead_ms - phase_lo;
+    }
+  }
+  
+  if(near && error <= int32_t(source_period) && error >= -int32_t(source_period)){
+    source_slew = -error; // Close enough to ease back in line, or already there
+  }
+  else{
+    source_count = value; // Too far out, jump
+    source_ms = constrain((phase_lo + phase_hi) / 2, 0, int32_t(source_period) - 1);
+    source_slew = 0;
+    source_refresh = true;
+  }
+  interrupts();
+}
+
+uint32_t Lixie_II::source_value(){
+  noInterrupts();
+  uint32_t value = source_count;
+  interrupts();
+  return value;
+}
+
 uint8_t Lixie_II::get_size(uint32_t input){
   uint8_t places = 1;
   while(input > 9){
@@ -648,15 +1288,463 @@ void Lixie_II::nixie(){
 
 void Lixie_II::white_balance(CRGB c_adj){
   lix_controller->setTemperature(c_adj);
+  mark_all_dirty();
 }
 
 void Lixie_II::rainbow(uint8_t r_hue, uint8_t r_sep){
-  for(uint8_t i = 0; i < n_digits; i++){
+  for(uint16_t i = 0; i < n_digits; i++){
     color_display(i, ON, CHSV(r_hue,255,255));
     r_hue+=r_sep;
   }
 }
 
+// save_state() / restore_state() snapshot, all multi-byte values big endian:
+//
+//   'L' 'S' | version | n_digits (uint16) | leds_per_digit
+//   target mask, one bit per LED
+//   ON then OFF layer: generator type, hue, hue_sep, hue step (int16),
+//                      then for GENERATOR_NONE, runs of (count, r, g, b)
+//   special panes enabled, one bit per display, then 6 color bytes per enabled pane
+//   brightness (uint16, 65535 = 1.0) | transition type | transition time (uint16) | dithering
+//   XOR of every byte before it
+
+class State_Writer{
+  public:
+    State_Writer(Print &out) : out(out), checksum(0), written(0){}
+    void put(uint8_t b){
+      checksum ^= b;
+      written += out.write(b);
+    }
+    void put16(uint16_t v){
+      put(v >> 8);
+      put(v);
+    }
+    Print &out;
+    uint8_t checksum;
+    size_t written;
+};
+
+// With keep set, every byte read is also copied to kept, grown as needed,
+// so a stream that can only be read once can be checked and then applied
+class State_Reader{
+  public:
+    State_Reader(Stream &in, bool keep = false) : in(in), checksum(0), ok(true), keep(keep), kept(NULL), kept_len(0), kept_size(0){}
+    ~State_Reader(){
+      delete[] kept;
+    }
+    uint8_t get(){
+      uint8_t b = 0;
+      if(in.readBytes(&b, 1) != 1){
+        ok = false;
+      }
+      checksum ^= b;
+      if(keep && ok){
+        store(b);
+      }
+      return b;
+    }
+    uint16_t get16(){
+      uint16_t v = get() << 8;
+      return v | get();
+    }
+    Stream &in;
+    uint8_t checksum;
+    bool ok;
+    bool keep;
+    uint8_t *kept;
+    uint16_t kept_len;
+    uint16_t kept_size;
+  private:
+    void store(uint8_t b){
+      if(kept_len == kept_size){
+        uint16_t new_size = (kept_size == 0) ? 64 : kept_size * 2;
+        uint8_t *grown = (new_size > kept_size) ? new uint8_t[new_size] : NULL;
+        if(grown == NULL){
+          ok = false; // Out of memory, or past 64KB
+          return;
+        }
+        if(kept != NULL){
+          memcpy(grown, kept, kept_len);
+          delete[] kept;
+        }
+        kept = grown;
+        kept_size = new_size;
+      }
+      kept[kept_len++] = b;
+    }
+};
+
+// Adapters for saving to / restoring from plain memory, such as an EEPROM image
+class Buffer_Print : public Print{
+  public:
+    Buffer_Print(uint8_t *buf, uint16_t size) : buf(buf), size(size), len(0), overflow(false){}
+    size_t write(uint8_t b){
+      if(len >= size){
+        overflow = true;
+        return 0;
+      }
+      buf[len++] = b;
+      return 1;
+    }
+    uint8_t *buf;
+    uint16_t size;
+    uint16_t len;
+    bool overflow;
+};
+
+class Buffer_Stream : public Stream{
+  public:
+    Buffer_Stream(const uint8_t *buf, uint16_t len) : buf(buf), len(len), pos(0){}
+    int available(){ return len - pos; }
+    int read(){ return (pos < len) ? buf[pos++] : -1; }
+    int peek(){ return (pos < len) ? buf[pos] : -1; }
+    size_t write(uint8_t){ return 0; }
+    void flush(){}
+    const uint8_t *buf;
+    uint16_t len;
+    uint16_t pos;
+};
+
+void save_layer(State_Writer &w, uint8_t layer){
+  lixie_generator &gen = generators[layer];
+  w.put(gen.type);
+  w.put(gen.hue >> 8);
+  w.put(gen.hue_sep);
+  w.put16(gen.hue_step);
+  if(gen.type != GENERATOR_NONE){
+    return; // No need for the colors underneath
+  }
+  
+  CRGB *cols = (layer == ON) ? col_on : col_off;
+  uint16_t i = 0;
+  while(i < n_LEDs){
+    uint8_t run = 1;
+    while(i + run < n_LEDs && run < 255 && cols[i+run] == cols[i]){
+      run++;
+    }
+    w.put(run);
+    w.put(cols[i].r);
+    w.put(cols[i].g);
+    w.put(cols[i].b);
+    i += run;
+  }
+}
+
+// With apply false, the layer is only read and checked
+bool restore_layer(State_Reader &r, uint8_t layer, bool apply){
+  lixie_generator &gen = generators[layer];
+  uint8_t type = r.get();
+  uint8_t hue = r.get();
+  uint8_t hue_sep = r.get();
+  int16_t hue_step = r.get16();
+  
+  if(!apply){
+    uint16_t i = 0;
+    while(type == GENERATOR_NONE && i < n_LEDs && r.ok){
+      uint8_t run = r.get();
+      r.get();
+      r.get();
+      r.get();
+      if(run == 0 || i + run > n_LEDs){
+        return false;
+      }
+      i += run;
+    }
+    return r.ok;
+  }
+  
+  if(type != GENERATOR_NONE){
+    if(gen.cache == NULL){
+      gen.cache = new CRGB[max_x_pos+1];
+    }
+    gen.hue = hue << 8;
+    gen.hue_sep = hue_sep;
+    gen.hue_step = hue_step;
+    gen.cache_valid = false;
+    gen.type = type;
+    return r.ok;
+  }
+  gen.type = GENERATOR_NONE;
+  
+  CRGB *cols = (layer == ON) ? col_on : col_off;
+  uint16_t i = 0;
+  while(i < n_LEDs && r.ok){
+    uint8_t run = r.get();
+    CRGB col;
+    col.r = r.get();
+    col.g = r.get();
+    col.b = r.get();
+    if(run == 0 || i + run > n_LEDs){
+      return false;
+    }
+    for(uint8_t j = 0; j < run; j++){
+      cols[i++] = col;
+    }
+  }
+  return r.ok;
+}
+
+size_t Lixie_II::save_state(Print &out){
+  State_Writer w(out);
+  w.put(LIXIE_STATE_MAGIC_0);
+  w.put(LIXIE_STATE_MAGIC_1);
+  w.put(LIXIE_STATE_VERSION);
+  w.put16(n_digits);
+  w.put(leds_per_digit);
+  
+  // Only where each display is heading matters, not the fade in between.
+  // Displays in a field head for the field's masks, not the global ones.
+  for(uint16_t i = 0; i < n_LEDs; i += 8){
+    uint8_t bits = 0;
+    for(uint8_t b = 0; b < 8 && i + b < n_LEDs; b++){
+      uint16_t digit = (i + b) / leds_per_digit;
+      uint8_t mask_index = current_mask;
+      if(digit_field[digit] != NO_FIELD){
+        mask_index = fields[digit_field[digit]].current_mask;
+      }
+      const uint8_t *mask_target = (mask_index == 0) ? led_mask_1 : led_mask_0;
+      if(mask_target[i+b] >= 128){
+        bits |= (1 << b);
+      }
+    }
+    w.put(bits);
+  }
+  
+  save_layer(w, ON);
+  save_layer(w, OFF);
+  
+  for(uint16_t d = 0; d < n_digits; d += 8){
+    uint8_t bits = 0;
+    for(uint8_t b = 0; b < 8 && d + b < n_digits; b++){
+      if(special_panes_enabled[d+b]){
+        bits |= (1 << b);
+      }
+    }
+    w.put(bits);
+  }
+  for(uint16_t d = 0; d < n_digits; d++){
+    if(special_panes_enabled[d]){
+      for(uint8_t c = 0; c < 2; c++){
+        w.put(special_panes_color[d*2+c].r);
+        w.put(special_panes_color[d*2+c].g);
+        w.put(special_panes_color[d*2+c].b);
+      }
+    }
+  }
+  
+  float level = constrain(bright, 0.0, 1.0);
+  w.put16(level * 65535);
+  w.put(trans_type);
+  w.put16(trans_time);
+  w.put(dither_enabled);
+  
+  w.put(w.checksum); // Zeroes the running checksum, so the reader can check for 0
+  return w.written;
+}
+
+uint16_t Lixie_II::save_state(uint8_t *buf, uint16_t size){
+  Buffer_Print out(buf, size);
+  save_state(out);
+  if(out.overflow){
+    return 0;
+  }
+  return out.len;
+}
+
+// Reads a whole snapshot, but only applies it if apply is set. Reading
+// it through once with apply false first means a corrupt snapshot
+// leaves the display untouched, rather than half restored.
+bool read_state(State_Reader &r, bool apply){
+  if(r.get() != LIXIE_STATE_MAGIC_0 || r.get() != LIXIE_STATE_MAGIC_1){
+    return false;
+  }
+  if(r.get() != LIXIE_STATE_VERSION){
+    return false;
+  }
+  if(r.get16() != n_digits || r.get() != leds_per_digit){
+    return false; // Saved from a different display
+  }
+  
+  for(uint16_t i = 0; i < n_LEDs; i += 8){
+    uint8_t bits = r.get();
+    for(uint8_t b = 0; b < 8 && i + b < n_LEDs && apply; b++){
+      uint8_t value = (bits & (1 << b)) ? 255 : 0;
+      led_mask_0[i+b] = value; // Both masks the same, so there's nothing to fade
+      led_mask_1[i+b] = value;
+    }
+  }
+  
+  if(!restore_layer(r, ON, apply) || !restore_layer(r, OFF, apply)){
+    return false;
+  }
+  
+  uint16_t panes_enabled = 0;
+  for(uint16_t d = 0; d < n_digits; d += 8){
+    uint8_t bits = r.get();
+    for(uint8_t b = 0; b < 8 && d + b < n_digits; b++){
+      if(bits & (1 << b)){
+        panes_enabled++;
+      }
+      if(apply){
+        special_panes_enabled[d+b] = bits & (1 << b);
+      }
+    }
+  }
+  if(apply){
+    for(uint16_t d = 0; d < n_digits; d++){
+      if(special_panes_enabled[d]){
+        for(uint8_t c = 0; c < 2; c++){
+          special_panes_color[d*2+c].r = r.get();
+          special_panes_color[d*2+c].g = r.get();
+          special_panes_color[d*2+c].b = r.get();
+        }
+      }
+    }
+  }
+  else{
+    for(uint16_t p = 0; p < panes_enabled * 6; p++){
+      r.get();
+    }
+  }
+  
+  float level = r.get16() / 65535.0;
+  uint8_t type = r.get();
+  uint16_t time = r.get16();
+  bool dither = r.get();
+  
+  r.get();
+  if(!r.ok || r.checksum != 0){
+    return false;
+  }
+  if(!apply){
+    return true;
+  }
+  
+  bright = level;
+  trans_type = type;
+  trans_time = time;
+  dither_enabled = dither;
+  
+  mask_fader = 1.0; // Show it as-is, no transition
+  mask_fade_finished = true;
+  for(uint8_t f = 0; f < LIXIE_MAX_FIELDS; f++){
+    fields[f].fader = 1.0; // Both masks match, so any field shows it as-is too
+  }
+  state_restored = true;
+  mark_all_dirty();
+  return true;
+}
+
+bool Lixie_II::restore_state(Stream &in){
+  State_Reader check(in, true); // A stream can only be read once
+  if(!read_state(check, false)){
+    return false;
+  }
+  return restore_state(check.kept, check.kept_len);
+}
+
+bool Lixie_II::restore_state(const uint8_t *buf, uint16_t len){
+  Buffer_Stream check_in(buf, len);
+  State_Reader check(check_in);
+  if(!read_state(check, false)){
+    return false;
+  }
+  
+  Buffer_Stream in(buf, len);
+  State_Reader r(in);
+  return read_state(r, true);
+}
+
+uint8_t Lixie_II::parse_packet(const uint8_t *buf, uint16_t len){
+  Lixie_Packet_Reader reader(buf, len);
+  if(reader.status() != LIXIE_OK){
+    return reader.status();
+  }
+  
+  if(staged_buffer == NULL){
+    staged_buffer = new uint8_t[n_digits];
+    staged_write = Lixie_Staged_Digits(staged_buffer, n_digits);
+  }
+  
+  const uint8_t *cmd;
+  while((cmd = reader.next()) != NULL){
+    switch(cmd[0]){
+      case LIXIE_CMD_WRITE_VALUE:
+        staged_write.write_value(((uint32_t)cmd[1] << 24) | ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4]);
+        break;
+      case LIXIE_CMD_WRITE_DIGITS:
+        staged_write.write_digits(cmd + 2, cmd[1]);
+        break;
+      case LIXIE_CMD_COLOR_ALL:
+        color_all(cmd[1], CRGB(cmd[2], cmd[3], cmd[4]));
+        break;
+      case LIXIE_CMD_COLOR_DISPLAY:
+        if(cmd[1] < n_digits){
+          color_display(cmd[1], cmd[2], CRGB(cmd[3], cmd[4], cmd[5]));
+        }
+        break;
+      case LIXIE_CMD_SPECIAL_PANE:
+        if(cmd[1] < n_digits){
+          special_pane(cmd[1], cmd[2], CRGB(cmd[3], cmd[4], cmd[5]), CRGB(cmd[6], cmd[7], cmd[8]));
+        }
+        break;
+      case LIXIE_CMD_BRIGHTNESS:
+        brightness(cmd[1] / 255.0f);
+        break;
+      case LIXIE_CMD_TRANSITION:
+        transition_type(cmd[1]);
+        transition_time((cmd[2] << 8) | cmd[3]);
+        break;
+      case LIXIE_CMD_COMMIT:
+        // Only now do the masks change, exactly as a write() would
+        if(staged_write.pending()){
+          staged_write.done();
+          clear_all();
+          for(uint16_t d = 0; d < staged_write.count(); d++){
+            push_digit(staged_write.digit(d));
+          }
+          if(current_mask == 0){
+            current_mask = 1;
+          }
+          else if(current_mask == 1){
+            current_mask = 0;
+          }
+          mask_update();
+        }
+        break;
+    }
+  }
+  
+  return LIXIE_OK;
+}
+
+bool Lixie_II::read_commands(Stream &input){
+  bool applied = false;
+  
+  while(input.available() > 0){
+    uint8_t b = input.read();
+    if(rx_len == 0 && b != LIXIE_PROTOCOL_MAGIC){
+      continue; // Hunt for the start of a packet
+    }
+    rx_buffer[rx_len++] = b;
+    
+    if(rx_len >= LIXIE_PROTOCOL_OVERHEAD - 1){
+      uint16_t packet_len = ((rx_buffer[2] << 8) | rx_buffer[3]) + LIXIE_PROTOCOL_OVERHEAD;
+      if(packet_len > LIXIE_MAX_PACKET){
+        rx_len = 0; // Too big to be ours, resync
+      }
+      else if(rx_len == packet_len){
+        if(parse_packet(rx_buffer, rx_len) == LIXIE_OK){
+          applied = true;
+        }
+        rx_len = 0;
+      }
+    }
+  }
+  
+  return applied;
+}
+
 void Lixie_II::clear(bool show_change){
   for(uint16_t i = 0; i < n_LEDs; i++){
     led_mask_0[i] = 0.0;
@@ -667,14 +1755,19 @@ void Lixie_II::clear(bool show_change){
     mask_push  = 1.0;
     mask_fade_finished = false;
   }
+  mark_all_dirty();
 }
 
-void Lixie_II::clear_digit(uint8_t index, bool show_change){
+void Lixie_II::clear_digit(uint16_t index, bool show_change){
+  if(index >= n_digits || digit_field[index] != NO_FIELD){
+    return;
+  }
   uint16_t start_index = index*leds_per_digit;  
-  for(uint16_t i = start_index; i < leds_per_digit; i++){
+  for(uint16_t i = start_index; i < start_index + leds_per_digit; i++){
     led_mask_0[i] = 0.0;
     led_mask_1[i] = 0.0;
   }
+  mark_dirty(index, 1);
 }
 
 void Lixie_II::show(){
@@ -712,7 +1805,7 @@ void Lixie_II::sweep(CRGB col, uint8_t speed){
 
 void Lixie_II::progress(float percent, CRGB col1, CRGB col2){
   uint16_t crossover_whole = percent * n_digits;
-  for(uint8_t i = 0; i < n_digits; i++){
+  for(uint16_t i = 0; i < n_digits; i++){
     if(n_digits-i-1 > crossover_whole){
       color_display(n_digits-i-1, ON, col1);
       color_display(n_digits-i-1, OFF, col1);
@@ -732,9 +1825,10 @@ void Lixie_II::fill_fade_in(CRGB col, uint8_t fade_speed){
       lix_leds[i].b = col.b*fade;
     }
     
-    FastLED.show();
+    show_frame(); // Through the output backend when one is set
     delay(fade_speed);
   }
+  mark_all_dirty();
 }
 
 void Lixie_II::fill_fade_out(CRGB col, uint8_t fade_speed){
@@ -745,9 +1839,10 @@ void Lixie_II::fill_fade_out(CRGB col, uint8_t fade_speed){
       lix_leds[i].b = col.b*fade;
     }
     
-    FastLED.show();
+    show_frame(); // Through the output backend when one is set
     delay(fade_speed);
   }
+  mark_all_dirty();
 }
 
 void Lixie_II::color(uint8_t r, uint8_t g, uint8_t b){
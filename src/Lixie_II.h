@@ -22,49 +22,173 @@
 // Aside from those issues, it's my tool of choice for WS2812B
 #include "FastLED.h"
 
+#include "Lixie_Protocol.h"
+#include "Lixie_Composite.h"
+
 #define ON  1
 #define OFF 0
 
 #define INSTANT   		0
 #define CROSSFADE 		1
 
+// Color generators, evaluated per X-position by the animation ISR
+#define GENERATOR_NONE		0
+#define GENERATOR_HUE		1 // Whole layer in one hue
+#define GENERATOR_GRADIENT	2 // Hue to (hue + hue_sep) from left to right
+#define GENERATOR_RAINBOW	3 // Each display offset by hue_sep from the last
+
+// on_event() callback events
+#define EVENT_TRANSITION_END	0 // A write finished fading in
+#define EVENT_COUNTDOWN_END		1 // countdown_source() reached zero
+
+// Field alignment, LIXIE_MAX_FIELDS is in Lixie_Composite.h
+#define ALIGN_RIGHT			0
+#define ALIGN_LEFT			1
+
+// Larger walls are cut down to fit, see the constructor
+#define LIXIE_MAX_LEDS		65520
+
+// save_state() snapshot header
+#define LIXIE_STATE_MAGIC_0		0x4C // 'L'
+#define LIXIE_STATE_MAGIC_1		0x53 // 'S'
+#define LIXIE_STATE_VERSION		2
+
+// Value sources, counted by the animation ISR
+#define SOURCE_NONE			0
+#define SOURCE_CLOCK		1 // HHMMSS (HHMM below 6 digits) from seconds since midnight
+#define SOURCE_COUNTDOWN	2 // Counts down once per period, stopping at zero
+#define SOURCE_COUNTER		3 // Counts up once per period
+#define LIXIE_PHASE_UNKNOWN	0xFFFF // sync_source() without the reference's milliseconds
+
+// Describes one hardware variant: which numeral each LED on a display
+// lights, and where it sits. The tables live in flash (PROGMEM), and are
+// generated at compile time by LIXIE_LAYOUT() below.
+struct Lixie_Layout
+{
+	uint8_t leds_per_digit;		// Up to 32
+	uint8_t x_width;			// X-positions across one display
+	const uint8_t *x_offsets;	// PROGMEM, X-position of each LED
+	const uint32_t *pane_bits;	// PROGMEM, LEDs lit for numerals 0-9, then the special pane
+	uint8_t special_leds[2];	// The special pane's LEDs (255 if missing)
+};
+
+#define LIXIE_SPECIAL_PANE 255 // Pane number of the special pane in a layout's pane list
+
+// Bitset of the LEDs in panes[] showing numeral - the inverse of the pane list
+constexpr uint32_t lixie_pane_bits(const uint8_t *panes, uint8_t n, uint8_t numeral, uint8_t i = 0){
+	return (i >= n) ? 0 : (((panes[i] == numeral) ? (1UL << i) : 0) | lixie_pane_bits(panes, n, numeral, i+1));
+}
+
+// First LED at or after i showing numeral, 255 if none
+constexpr uint8_t lixie_find_led(const uint8_t *panes, uint8_t n, uint8_t numeral, uint8_t i = 0){
+	return (i >= n) ? 255 : ((panes[i] == numeral) ? i : lixie_find_led(panes, n, numeral, i+1));
+}
+
+// Next LED after prev showing numeral, 255 if none
+constexpr uint8_t lixie_find_next_led(const uint8_t *panes, uint8_t n, uint8_t numeral, uint8_t prev){
+	return (prev == 255) ? 255 : lixie_find_led(panes, n, numeral, prev+1);
+}
+
+// Builds a Lixie_Layout called "name" from a constexpr pane list (numeral per LED,
+// LIXIE_SPECIAL_PANE for the special pane) and a PROGMEM list of X-offsets:
+//
+//   static constexpr uint8_t my_panes[20] = { ... };
+//   const uint8_t my_x[20] PROGMEM = { ... };
+//   LIXIE_LAYOUT(my_layout, my_panes, my_x, 2);
+//   Lixie_II lix(DATA_PIN, NUM_DIGITS, my_layout);
+#define LIXIE_LAYOUT(name, panes, offsets, width) \
+	static_assert(sizeof(panes) <= 32, "Lixie layouts hold up to 32 LEDs per display"); \
+	const uint32_t name##_pane_bits[11] PROGMEM = { \
+		lixie_pane_bits(panes, sizeof(panes), 0), lixie_pane_bits(panes, sizeof(panes), 1), \
+		lixie_pane_bits(panes, sizeof(panes), 2), lixie_pane_bits(panes, sizeof(panes), 3), \
+		lixie_pane_bits(panes, sizeof(panes), 4), lixie_pane_bits(panes, sizeof(panes), 5), \
+		lixie_pane_bits(panes, sizeof(panes), 6), lixie_pane_bits(panes, sizeof(panes), 7), \
+		lixie_pane_bits(panes, sizeof(panes), 8), lixie_pane_bits(panes, sizeof(panes), 9), \
+		lixie_pane_bits(panes, sizeof(panes), LIXIE_SPECIAL_PANE) \
+	}; \
+	const Lixie_Layout name = { \
+		sizeof(panes), width, offsets, name##_pane_bits, { \
+			lixie_find_led(panes, sizeof(panes), LIXIE_SPECIAL_PANE), \
+			lixie_find_next_led(panes, sizeof(panes), LIXIE_SPECIAL_PANE, lixie_find_led(panes, sizeof(panes), LIXIE_SPECIAL_PANE)) \
+		} \
+	}
+
+extern const Lixie_Layout LIXIE_II_LAYOUT; // 22 LEDs, default
+extern const Lixie_Layout LIXIE_1_LAYOUT;  // 20 LEDs, original Lixie
+
+// Anything that can take a finished frame instead of the local FastLED
+// controller, such as Lixie_UDP_Output. show() is called from the animation
+// ISR (or run()) whenever the frame changes, and on any frame where
+// refresh_due() asks for the unchanged one to be sent again.
+class Lixie_Output
+{
+	public:
+		virtual void show(CRGB *leds, uint16_t n_leds) = 0;
+		virtual bool refresh_due(){ return false; }
+};
+
 // Functions
 class Lixie_II
 {
 	public:
-		Lixie_II(const uint8_t pin, uint8_t n_digits);
+		Lixie_II(const uint8_t pin, uint16_t n_digits, const Lixie_Layout &layout = LIXIE_II_LAYOUT);
 		void build_controller(const uint8_t pin);
+		void output(Lixie_Output *out);
 		void begin();
 		void transition_type(uint8_t type);
 		void transition_time(uint16_t ms);
 		void max_power(uint8_t V, uint16_t mA);
 		void color_all(uint8_t layer, CRGB col);
 		void color_all_dual(uint8_t layer, CRGB col_left, CRGB col_right);
-		void color_display(uint8_t display, uint8_t layer, CRGB col);
+		void color_display(uint16_t display, uint8_t layer, CRGB col);
 		void gradient_rgb(uint8_t layer, CRGB col_left, CRGB col_right);
+		void color_generator(uint8_t layer, uint8_t type, uint8_t hue, uint8_t hue_sep = 0, float rate = 0.0);
 		void start_animation();
 		void stop_animation();
 		void write(uint32_t input);
 		void write(String input);
 		void write_float(float input, uint8_t dec_places = 1);
+		uint8_t add_field(uint16_t first_digit, uint16_t width, uint8_t align = ALIGN_RIGHT, bool zero_pad = false);
+		void remove_field(uint8_t id);
+		void write_field(uint8_t id, uint32_t value);
+		void field_transition(uint8_t id, uint8_t type, uint16_t ms);
+		void field_color(uint8_t id, uint8_t layer, CRGB col);
+		bool field_finished(uint8_t id);
+		void clock_source(uint32_t seconds, bool hour_12 = false);
+		void countdown_source(uint32_t start, uint16_t period_ms = 1000);
+		void counter_source(uint32_t start = 0, uint16_t period_ms = 1000);
+		void stop_source();
+		void sync_source(uint32_t value, uint16_t phase_ms = LIXIE_PHASE_UNKNOWN);
+		uint32_t source_value();
 		void clear_all();
-		void write_digit(uint8_t digit, uint8_t num);
+		void write_digit(uint16_t digit, uint8_t num);
 		void push_digit(uint8_t number);
-		void clear_digit(uint8_t digit, uint8_t num);
-		void special_pane(uint8_t index, bool enabled, CRGB col1 = CRGB(0,0,0), CRGB col2 = CRGB(0,0,0));
+		void clear_digit(uint16_t digit, uint8_t num);
+		void special_pane(uint16_t index, bool enabled, CRGB col1 = CRGB(0,0,0), CRGB col2 = CRGB(0,0,0));
 		void mask_update();
 		void fade_in();
 		void fade_out();
 		void brightness(float level);
 	        void brightness(double level);
+		void dithering(bool enabled);
+		void composite_kernel(uint8_t kernel);
+		uint8_t composite_cores(uint8_t cores);
 		void run();
 		void wait();
+		bool transition_finished();
+		void on_event(void (*callback)(uint8_t event));
 		void streak(CRGB col, float pos, uint8_t blur);
 		void sweep_color(CRGB col, uint16_t speed, uint8_t blur, bool reverse = false);
 		void sweep_gradient(CRGB col_left, CRGB col_right, uint16_t speed, uint8_t blur, bool reverse = false);
 		void nixie();
 		void white_balance(CRGB c_adj);
 		void rainbow(uint8_t r_hue, uint8_t r_sep);
+		size_t save_state(Print &out);
+		uint16_t save_state(uint8_t *buf, uint16_t size);
+		bool restore_state(Stream &in);
+		bool restore_state(const uint8_t *buf, uint16_t len);
+		uint8_t parse_packet(const uint8_t *buf, uint16_t len);
+		bool read_commands(Stream &input);
 		
 		// ----------------------------------------------
 		// Deprecated Lixie 1 functions and overloads:
@@ -72,7 +196,7 @@ class Lixie_II
 		
 		void brightness(uint8_t b);
 		void clear(bool show_change = true);
-		void clear_digit(uint8_t index, bool show_change = true);
+		void clear_digit(uint16_t index, bool show_change = true);
 		void show();
 		void write_flip(uint32_t input, uint16_t flip_time = 100, uint8_t flip_speed = 10);
 		void write_fade(uint32_t input, uint16_t fade_time = 250);
@@ -98,6 +222,7 @@ class Lixie_II
 		
 	private:
 		uint8_t get_size(uint32_t input);
+		void push_value(uint32_t input);
 };
 
 #endif
@@ -0,0 +1,344 @@
+/*
+	Lixie_Protocol.h - Binary command protocol for Lixie II displays
+	
+	Both the encoder and the decoder Lixie_II.cpp uses live below. Nothing
+	in here depends on Arduino, so the same file can build command packets
+	on a host machine for a whole fleet of clocks, and be checked there -
+	see extras/host.
+	
+	Released under the GPLv3 License
+*/
+
+#ifndef lixie_protocol_h
+#define lixie_protocol_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Packet layout:
+//
+//   'L' | version | payload length (uint16, big endian) | payload | checksum
+//
+// The payload is any number of commands, each an opcode followed by its
+// arguments. All multi-byte values are big endian. The checksum is the XOR
+// of every payload byte. Writes are staged, and only shown after a COMMIT.
+
+#define LIXIE_PROTOCOL_MAGIC    0x4C // 'L'
+#define LIXIE_PROTOCOL_VERSION  1
+#define LIXIE_PROTOCOL_OVERHEAD 5    // Header + checksum
+#define LIXIE_MAX_PACKET        128  // Largest packet read_commands() buffers
+
+// Opcodes                                // Arguments
+#define LIXIE_CMD_WRITE_VALUE    0x01     // uint32 value
+#define LIXIE_CMD_WRITE_DIGITS   0x02     // count, digits[count] (0-9, 128 = blank, 255 = special pane)
+#define LIXIE_CMD_COLOR_ALL      0x03     // layer, r, g, b
+#define LIXIE_CMD_COLOR_DISPLAY  0x04     // display, layer, r, g, b
+#define LIXIE_CMD_SPECIAL_PANE   0x05     // index, enabled, r1, g1, b1, r2, g2, b2
+#define LIXIE_CMD_BRIGHTNESS     0x06     // level (0-255)
+#define LIXIE_CMD_TRANSITION     0x07     // type, uint16 ms
+#define LIXIE_CMD_COMMIT         0x08     // (none)
+
+// parse_packet() results
+#define LIXIE_OK                 0
+#define LIXIE_BAD_HEADER         1
+#define LIXIE_BAD_VERSION        2
+#define LIXIE_BAD_LENGTH         3
+#define LIXIE_BAD_CHECKSUM       4
+#define LIXIE_BAD_COMMAND        5
+
+// Builds a packet in a caller-supplied buffer, no heap required:
+//
+//   uint8_t buf[LIXIE_MAX_PACKET];
+//   Lixie_Packet packet(buf, sizeof(buf));
+//   packet.write_value(1234);
+//   packet.commit();
+//   uint16_t len = packet.finish(); // 0 if it didn't fit
+class Lixie_Packet
+{
+	public:
+		Lixie_Packet(uint8_t *buf, uint16_t size){
+			buffer = buf;
+			buffer_size = size;
+			reset();
+		}
+		
+		void reset(){
+			len = LIXIE_PROTOCOL_OVERHEAD - 1; // Header is filled in by finish()
+			overflow = (buffer_size < LIXIE_PROTOCOL_OVERHEAD);
+		}
+		
+		void write_value(uint32_t value){
+			if(room(5)){
+				put(LIXIE_CMD_WRITE_VALUE);
+				put(value >> 24); put(value >> 16); put(value >> 8); put(value);
+			}
+		}
+		
+		void write_digits(const uint8_t *digits, uint8_t count){
+			if(room(2 + count)){
+				put(LIXIE_CMD_WRITE_DIGITS);
+				put(count);
+				for(uint8_t i = 0; i < count; i++){
+					put(digits[i]);
+				}
+			}
+		}
+		
+		void color_all(uint8_t layer, uint8_t r, uint8_t g, uint8_t b){
+			if(room(5)){
+				put(LIXIE_CMD_COLOR_ALL);
+				put(layer); put(r); put(g); put(b);
+			}
+		}
+		
+		void color_display(uint8_t display, uint8_t layer, uint8_t r, uint8_t g, uint8_t b){
+			if(room(6)){
+				put(LIXIE_CMD_COLOR_DISPLAY);
+				put(display); put(layer); put(r); put(g); put(b);
+			}
+		}
+		
+		void special_pane(uint8_t index, bool enabled, uint8_t r1 = 0, uint8_t g1 = 0, uint8_t b1 = 0, uint8_t r2 = 0, uint8_t g2 = 0, uint8_t b2 = 0){
+			if(room(9)){
+				put(LIXIE_CMD_SPECIAL_PANE);
+				put(index); put(enabled);
+				put(r1); put(g1); put(b1);
+				put(r2); put(g2); put(b2);
+			}
+		}
+		
+		void brightness(uint8_t level){
+			if(room(2)){
+				put(LIXIE_CMD_BRIGHTNESS);
+				put(level);
+			}
+		}
+		
+		void transition(uint8_t type, uint16_t ms){
+			if(room(4)){
+				put(LIXIE_CMD_TRANSITION);
+				put(type); put(ms >> 8); put(ms);
+			}
+		}
+		
+		void commit(){
+			if(room(1)){
+				put(LIXIE_CMD_COMMIT);
+			}
+		}
+		
+		uint16_t finish(){
+			if(overflow){
+				return 0;
+			}
+			
+			uint16_t payload_len = len - (LIXIE_PROTOCOL_OVERHEAD - 1);
+			uint8_t checksum = 0;
+			for(uint16_t i = LIXIE_PROTOCOL_OVERHEAD - 1; i < len; i++){
+				checksum ^= buffer[i];
+			}
+			
+			buffer[0] = LIXIE_PROTOCOL_MAGIC;
+			buffer[1] = LIXIE_PROTOCOL_VERSION;
+			buffer[2] = payload_len >> 8;
+			buffer[3] = payload_len;
+			buffer[len] = checksum;
+			
+			return len + 1;
+		}
+		
+	private:
+		bool room(uint16_t bytes){
+			if(len + bytes + 1 > buffer_size){ // +1 keeps space for the checksum
+				overflow = true;
+			}
+			return !overflow;
+		}
+		
+		void put(uint8_t b){
+			buffer[len++] = b;
+		}
+		
+		uint8_t *buffer;
+		uint16_t buffer_size;
+		uint16_t len;
+		bool overflow;
+};
+
+// Size of the command at cmd (opcode included), or 0 if it's unknown or
+// runs past the end of the payload
+inline uint16_t lixie_command_length(const uint8_t *cmd, uint16_t remaining){
+	uint16_t len = 0;
+	switch(cmd[0]){
+		case LIXIE_CMD_WRITE_VALUE:   len = 5; break;
+		case LIXIE_CMD_WRITE_DIGITS:  len = (remaining >= 2) ? 2 + cmd[1] : 2; break;
+		case LIXIE_CMD_COLOR_ALL:     len = 5; break;
+		case LIXIE_CMD_COLOR_DISPLAY: len = 6; break;
+		case LIXIE_CMD_SPECIAL_PANE:  len = 9; break;
+		case LIXIE_CMD_BRIGHTNESS:    len = 2; break;
+		case LIXIE_CMD_TRANSITION:    len = 4; break;
+		case LIXIE_CMD_COMMIT:        len = 1; break;
+	}
+	if(len > remaining){
+		return 0;
+	}
+	return len;
+}
+
+// Checks a whole packet up front, so a bad one changes nothing, then hands
+// out its commands one at a time:
+//
+//   Lixie_Packet_Reader reader(buf, len);
+//   if(reader.status() == LIXIE_OK){
+//     const uint8_t *cmd;
+//     while((cmd = reader.next()) != NULL){
+//       // cmd[0] is the opcode, its arguments follow
+//     }
+//   }
+class Lixie_Packet_Reader
+{
+	public:
+		Lixie_Packet_Reader(const uint8_t *buf, uint16_t len){
+			payload = NULL;
+			payload_len = 0;
+			pos = 0;
+			result = check(buf, len);
+		}
+		
+		uint8_t status(){
+			return result;
+		}
+		
+		// The next command, or NULL once there are none left
+		const uint8_t *next(){
+			if(result != LIXIE_OK || pos >= payload_len){
+				return NULL;
+			}
+			const uint8_t *cmd = payload + pos;
+			pos += lixie_command_length(cmd, payload_len - pos);
+			return cmd;
+		}
+		
+	private:
+		uint8_t check(const uint8_t *buf, uint16_t len){
+			if(len < LIXIE_PROTOCOL_OVERHEAD || buf[0] != LIXIE_PROTOCOL_MAGIC){
+				return LIXIE_BAD_HEADER;
+			}
+			if(buf[1] != LIXIE_PROTOCOL_VERSION){
+				return LIXIE_BAD_VERSION;
+			}
+			
+			uint16_t body_len = (buf[2] << 8) | buf[3];
+			if(body_len + LIXIE_PROTOCOL_OVERHEAD != len){
+				return LIXIE_BAD_LENGTH;
+			}
+			
+			const uint8_t *body = buf + (LIXIE_PROTOCOL_OVERHEAD - 1);
+			uint8_t checksum = 0;
+			for(uint16_t i = 0; i < body_len; i++){
+				checksum ^= body[i];
+			}
+			if(checksum != body[body_len]){
+				return LIXIE_BAD_CHECKSUM;
+			}
+			
+			for(uint16_t i = 0; i < body_len;){
+				uint16_t cmd_len = lixie_command_length(body + i, body_len - i);
+				if(cmd_len == 0){
+					return LIXIE_BAD_COMMAND;
+				}
+				i += cmd_len;
+			}
+			
+			payload = body;
+			payload_len = body_len;
+			return LIXIE_OK;
+		}
+		
+		const uint8_t *payload;
+		uint16_t payload_len;
+		uint16_t pos;
+		uint8_t result;
+};
+
+// Keeps the digits of the last WRITE_VALUE or WRITE_DIGITS until a COMMIT
+// shows them, so nothing on the displays changes before then - not even
+// the side of a fade that's still running. Each write replaces the last,
+// and only the newest size digits are kept, since a wall of size displays
+// would push the older ones off anyway.
+class Lixie_Staged_Digits
+{
+	public:
+		Lixie_Staged_Digits(uint8_t *buf = NULL, uint16_t size = 0){
+			buffer = buf;
+			buffer_size = size;
+			head = 0;
+			kept = 0;
+			staged = false;
+		}
+		
+		void write_value(uint32_t value){
+			uint8_t places[10]; // Enough for any uint32
+			uint8_t n = 0;
+			do{
+				places[n++] = value % 10;
+				value /= 10;
+			} while(value > 0);
+			
+			clear();
+			while(n > 0){
+				push(places[--n]);
+			}
+		}
+		
+		void write_digits(const uint8_t *digits, uint8_t count){
+			clear();
+			for(uint8_t i = 0; i < count; i++){
+				push(digits[i]);
+			}
+		}
+		
+		// True from a write until done() is called
+		bool pending(){
+			return staged;
+		}
+		
+		void done(){
+			staged = false;
+		}
+		
+		uint16_t count(){
+			return kept;
+		}
+		
+		// Oldest first, the order they'd be pushed onto the displays in
+		uint8_t digit(uint16_t i){
+			return buffer[(head + buffer_size - kept + i) % buffer_size];
+		}
+		
+	private:
+		void clear(){
+			head = 0;
+			kept = 0;
+			staged = true;
+		}
+		
+		void push(uint8_t d){
+			if(buffer_size == 0){
+				return;
+			}
+			buffer[head] = d;
+			head = (head + 1) % buffer_size;
+			if(kept < buffer_size){
+				kept++;
+			}
+		}
+		
+		uint8_t *buffer;
+		uint16_t buffer_size;
+		uint16_t head; // Where the next digit goes
+		uint16_t kept;
+		bool staged;
+};
+
+#endif
@@ -0,0 +1,51 @@
+/*
+  Lixie_UDP_Output.cpp - Streams Lixie II frames to remote pixel
+  controllers as DDP or E1.31 (sACN) over any Arduino UDP class
+  
+  Released under the GPLv3 License
+*/
+
+#include "Lixie_UDP_Output.h"
+
+Lixie_UDP_Output::Lixie_UDP_Output(UDP &udp_in, IPAddress ip_in, uint8_t protocol_in, uint16_t universe_in) : packer(protocol_in, universe_in){
+  udp = &udp_in;
+  ip = ip_in;
+  last_hash = 0;
+  last_sent_ms = 0;
+  frame_sent = false;
+}
+
+void Lixie_UDP_Output::force_update(){
+  frame_sent = false;
+}
+
+bool Lixie_UDP_Output::refresh_due(){
+  return frame_sent && (millis() - last_sent_ms >= LIXIE_UDP_REFRESH_MS);
+}
+
+void Lixie_UDP_Output::show(CRGB *leds, uint16_t n_leds){
+  // CRGB is stored as packed R,G,B bytes, which is already the wire format
+  const uint8_t *data = (const uint8_t*)leds;
+  uint32_t len = (uint32_t)n_leds * 3; // Over 64KB past 21845 LEDs
+  
+  uint32_t hash = lixie_frame_hash(data, len);
+  if(frame_sent && hash == last_hash && !refresh_due()){
+    return;
+  }
+  last_hash = hash;
+  last_sent_ms = millis();
+  frame_sent = true;
+  
+  uint8_t header[LIXIE_UDP_MAX_HEADER];
+  uint16_t header_len;
+  const uint8_t *chunk;
+  uint16_t chunk_len;
+  
+  packer.start(data, len);
+  while(packer.next(header, header_len, chunk, chunk_len)){
+    udp->beginPacket(ip, packer.port());
+    udp->write(header, header_len);
+    udp->write(chunk, chunk_len);
+    udp->endPacket();
+  }
+}
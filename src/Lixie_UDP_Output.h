@@ -0,0 +1,36 @@
+/*
+	Lixie_UDP_Output.h - Streams Lixie II frames to remote pixel
+	controllers as DDP or E1.31 (sACN) over any Arduino UDP class
+	
+	Released under the GPLv3 License
+*/
+
+#ifndef lixie_udp_output_h
+#define lixie_udp_output_h
+
+#include "Lixie_II.h"
+#include "Lixie_UDP_Packer.h"
+#include "Udp.h"
+
+// Unchanged frames are still resent this often, as receivers treat a
+// silent source as lost (after 2.5s for E1.31)
+#define LIXIE_UDP_REFRESH_MS 1000
+
+class Lixie_UDP_Output : public Lixie_Output
+{
+	public:
+		Lixie_UDP_Output(UDP &udp, IPAddress ip, uint8_t protocol = LIXIE_DDP, uint16_t universe = 1);
+		void show(CRGB *leds, uint16_t n_leds);
+		bool refresh_due();
+		void force_update();
+		
+	private:
+		UDP *udp;
+		IPAddress ip;
+		Lixie_UDP_Packer packer;
+		uint32_t last_hash;
+		uint32_t last_sent_ms;
+		bool frame_sent;
+};
+
+#endif
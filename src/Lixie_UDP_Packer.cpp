@@ -0,0 +1,119 @@
+/*
+  Lixie_UDP_Packer.cpp - Splits a frame of RGB bytes into DDP or E1.31
+  (sACN) packets
+  
+  Released under the GPLv3 License
+*/
+
+#include "Lixie_UDP_Packer.h"
+#include <string.h>
+
+const uint8_t e131_cid[16] = { 0x4c, 0x69, 0x78, 0x69, 0x65, 0x20, 0x49, 0x49, 0x10, 0x00, 0x80, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+Lixie_UDP_Packer::Lixie_UDP_Packer(uint8_t protocol_in, uint16_t universe_in){
+  protocol = protocol_in;
+  universe = universe_in;
+  sequence = 0;
+  data = NULL;
+  len = 0;
+  offset = 0;
+}
+
+uint16_t Lixie_UDP_Packer::port(){
+  return (protocol == LIXIE_E131) ? LIXIE_E131_PORT : LIXIE_DDP_PORT;
+}
+
+void Lixie_UDP_Packer::start(const uint8_t *data_in, uint32_t len_in){
+  data = data_in;
+  len = len_in;
+  offset = 0;
+  
+  // One sequence number per frame, shared by all of its packets. E1.31
+  // receivers track it per universe, so counting packets would make every
+  // universe jump ahead by the number of universes each frame.
+  sequence++;
+  if(protocol == LIXIE_DDP && sequence > 15){
+    sequence = 1; // 0 means "no sequence" to DDP receivers
+  }
+}
+
+bool Lixie_UDP_Packer::next(uint8_t *header, uint16_t &header_len, const uint8_t *&chunk, uint16_t &chunk_len){
+  if(data == NULL || offset >= len){
+    return false;
+  }
+  
+  uint16_t max_data = (protocol == LIXIE_E131) ? LIXIE_E131_MAX_DATA : LIXIE_DDP_MAX_DATA;
+  chunk_len = max_data;
+  if(len - offset < max_data){
+    chunk_len = len - offset;
+  }
+  chunk = data + offset;
+  
+  if(protocol == LIXIE_E131){
+    header_len = e131_header(header, chunk_len);
+  }
+  else{
+    header_len = ddp_header(header, chunk_len);
+  }
+  
+  offset += chunk_len;
+  return true;
+}
+
+uint16_t Lixie_UDP_Packer::ddp_header(uint8_t *header, uint16_t chunk_len){
+  bool last = (offset + chunk_len >= len);
+  
+  header[0] = 0x40 | (last ? 0x01 : 0x00); // Version 1, PUSH on the final packet
+  header[1] = sequence;
+  header[2] = 0x0B;                        // RGB, 8 bits per channel
+  header[3] = 0x01;                        // Default output device
+  header[4] = offset >> 24;                // 32-bit offset
+  header[5] = offset >> 16;
+  header[6] = offset >> 8;
+  header[7] = offset;
+  header[8] = chunk_len >> 8;
+  header[9] = chunk_len;
+  return LIXIE_DDP_HEADER_LEN;
+}
+
+uint16_t Lixie_UDP_Packer::e131_header(uint8_t *header, uint16_t chunk_len){
+  uint16_t packet_len = LIXIE_E131_HEADER_LEN + chunk_len;
+  uint16_t uni = universe + (offset / LIXIE_E131_MAX_DATA);
+  memset(header, 0, LIXIE_E131_HEADER_LEN);
+  
+  // Root layer
+  header[1] = 0x10;                             // Preamble size
+  memcpy(header + 4, "ASC-E1.17", 9);           // ACN packet identifier
+  header[16] = 0x70 | ((packet_len - 16) >> 8);
+  header[17] = packet_len - 16;
+  header[21] = 0x04;                            // VECTOR_ROOT_E131_DATA
+  memcpy(header + 22, e131_cid, 16);
+  
+  // Framing layer
+  header[38] = 0x70 | ((packet_len - 38) >> 8);
+  header[39] = packet_len - 38;
+  header[43] = 0x02;                            // VECTOR_E131_DATA_PACKET
+  memcpy(header + 44, "Lixie II", 8);           // Source name
+  header[108] = 100;                            // Priority
+  header[111] = sequence;
+  header[113] = uni >> 8;
+  header[114] = uni;
+  
+  // DMP layer
+  header[115] = 0x70 | ((packet_len - 115) >> 8);
+  header[116] = packet_len - 115;
+  header[117] = 0x02;                           // VECTOR_DMP_SET_PROPERTY
+  header[118] = 0xA1;                           // Address & data type
+  header[122] = 0x01;                           // Address increment
+  header[123] = (chunk_len + 1) >> 8;           // Property count, with start code
+  header[124] = chunk_len + 1;
+  return LIXIE_E131_HEADER_LEN;
+}
+
+uint32_t lixie_frame_hash(const uint8_t *data, uint32_t len){
+  uint32_t hash = 2166136261UL;
+  for(uint32_t i = 0; i < len; i++){
+    hash = (hash ^ data[i]) * 16777619UL;
+  }
+  return hash;
+}
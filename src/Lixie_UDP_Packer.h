@@ -0,0 +1,57 @@
+/*
+	Lixie_UDP_Packer.h - Splits a frame of RGB bytes into DDP or E1.31
+	(sACN) packets
+	
+	Used by Lixie_UDP_Output. Like Lixie_Protocol.h, nothing in here
+	depends on Arduino, so the packets can be built and checked on a host.
+	
+	Released under the GPLv3 License
+*/
+
+#ifndef lixie_udp_packer_h
+#define lixie_udp_packer_h
+
+#include <stdint.h>
+
+#define LIXIE_DDP  0
+#define LIXIE_E131 1
+
+#define LIXIE_DDP_PORT  4048
+#define LIXIE_E131_PORT 5568
+
+// DDP carries up to 480 RGB pixels per packet, E1.31 170 per universe
+#define LIXIE_DDP_HEADER_LEN	10
+#define LIXIE_DDP_MAX_DATA		1440
+#define LIXIE_E131_HEADER_LEN	126
+#define LIXIE_E131_MAX_DATA		510
+
+#define LIXIE_UDP_MAX_HEADER	LIXIE_E131_HEADER_LEN
+
+// Call start() with a frame, then next() until it returns false. Each
+// packet is a header written into the caller's buffer (at least
+// LIXIE_UDP_MAX_HEADER bytes), followed by a chunk of the frame itself,
+// which is never copied.
+class Lixie_UDP_Packer
+{
+	public:
+		Lixie_UDP_Packer(uint8_t protocol = LIXIE_DDP, uint16_t universe = 1);
+		void start(const uint8_t *data, uint32_t len);
+		bool next(uint8_t *header, uint16_t &header_len, const uint8_t *&chunk, uint16_t &chunk_len);
+		uint16_t port();
+		
+	private:
+		uint16_t ddp_header(uint8_t *header, uint16_t chunk_len);
+		uint16_t e131_header(uint8_t *header, uint16_t chunk_len);
+		
+		uint8_t protocol;
+		uint16_t universe;
+		uint8_t sequence;
+		const uint8_t *data;
+		uint32_t len;		// Up to LIXIE_MAX_LEDS * 3, past 16 bits
+		uint32_t offset;
+};
+
+// FNV-1a, so unchanged frames can be spotted without keeping a copy
+uint32_t lixie_frame_hash(const uint8_t *data, uint32_t len);
+
+#endif